@@ -0,0 +1,264 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+// Headless benchmark for the audio engine
+// Loads patches into a PluginProcessor without an editor and measures how long processBlock takes
+
+#include <JuceHeader.h>
+
+#include <PluginProcessor.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+
+// Allocation hook: counts every C++ allocation made on a thread that has counting enabled
+// Note that Pd itself allocates through malloc, which this won't see
+static std::atomic<int64> numAllocations = 0;
+static thread_local bool countAllocations = false;
+
+void* operator new(std::size_t size)
+{
+    if (countAllocations)
+        numAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct BenchmarkSettings {
+    Array<File> patches;
+    Array<double> sampleRates = { 44100.0, 48000.0, 96000.0 };
+    Array<int> blockSizes = { 64, 256, 1024 };
+    double seconds = 10.0;
+    int oversampling = 0;
+};
+
+struct BenchmarkResult {
+    std::vector<double> blockTimes; // in milliseconds
+    std::vector<int64> blockAllocations;
+    double deadline = 0.0; // in milliseconds
+    int numDeadlineMisses = 0;
+
+    double getPercentile(double percentile) const
+    {
+        if (blockTimes.empty())
+            return 0.0;
+
+        auto sorted = blockTimes;
+        std::sort(sorted.begin(), sorted.end());
+        auto index = static_cast<size_t>(std::round(percentile / 100.0 * static_cast<double>(sorted.size() - 1)));
+        return sorted[index];
+    }
+
+    double getMean() const
+    {
+        if (blockTimes.empty())
+            return 0.0;
+
+        return std::accumulate(blockTimes.begin(), blockTimes.end(), 0.0) / static_cast<double>(blockTimes.size());
+    }
+};
+
+static BenchmarkResult runBenchmark(File const& patchFile, double sampleRate, int blockSize, BenchmarkSettings const& settings)
+{
+    BenchmarkResult result;
+
+    auto processor = std::make_unique<PluginProcessor>();
+
+    processor->oversampling = settings.oversampling;
+
+    auto const numChannels = std::max(processor->getTotalNumInputChannels(), processor->getTotalNumOutputChannels());
+    processor->prepareToPlay(sampleRate, blockSize);
+
+    if (!processor->loadPatch(patchFile)) {
+        std::cerr << "Couldn't load " << patchFile.getFullPathName() << std::endl;
+        return result;
+    }
+
+    AudioBuffer<float> buffer(numChannels, blockSize);
+    MidiBuffer midiBuffer;
+
+    // Process one second first, so loadbangs and initial allocations don't end up in the results
+    auto const warmupBlocks = static_cast<int>(sampleRate / blockSize);
+    for (int i = 0; i < warmupBlocks; i++) {
+        buffer.clear();
+        midiBuffer.clear();
+        processor->processBlock(buffer, midiBuffer);
+    }
+
+    auto const numBlocks = static_cast<int>(settings.seconds * sampleRate / blockSize);
+    result.deadline = 1000.0 * blockSize / sampleRate;
+    result.blockTimes.reserve(numBlocks);
+    result.blockAllocations.reserve(numBlocks);
+
+    for (int i = 0; i < numBlocks; i++) {
+        buffer.clear();
+        midiBuffer.clear();
+
+        auto const allocationsBefore = numAllocations.load();
+        countAllocations = true;
+        auto const start = Time::getHighResolutionTicks();
+
+        processor->processBlock(buffer, midiBuffer);
+
+        auto const end = Time::getHighResolutionTicks();
+        countAllocations = false;
+
+        auto const blockTime = Time::highResolutionTicksToSeconds(end - start) * 1000.0;
+        result.blockTimes.push_back(blockTime);
+        result.blockAllocations.push_back(numAllocations.load() - allocationsBefore);
+
+        if (blockTime > result.deadline)
+            result.numDeadlineMisses++;
+    }
+
+    processor->releaseResources();
+
+    return result;
+}
+
+static void printResult(File const& patchFile, double sampleRate, int blockSize, BenchmarkResult const& result)
+{
+    if (result.blockTimes.empty())
+        return;
+
+    auto const totalAllocations = std::accumulate(result.blockAllocations.begin(), result.blockAllocations.end(), int64(0));
+    auto const maxAllocations = *std::max_element(result.blockAllocations.begin(), result.blockAllocations.end());
+
+    auto line = patchFile.getFileNameWithoutExtension().paddedRight(' ', 16)
+        + String(sampleRate, 0).paddedLeft(' ', 8)
+        + String(blockSize).paddedLeft(' ', 7)
+        + String(result.getMean(), 4).paddedLeft(' ', 10)
+        + String(result.getPercentile(50.0), 4).paddedLeft(' ', 10)
+        + String(result.getPercentile(90.0), 4).paddedLeft(' ', 10)
+        + String(result.getPercentile(99.0), 4).paddedLeft(' ', 10)
+        + String(result.getPercentile(99.9), 4).paddedLeft(' ', 10)
+        + String(result.getPercentile(100.0), 4).paddedLeft(' ', 10)
+        + String(100.0 * result.getMean() / result.deadline, 1).paddedLeft(' ', 8)
+        + String(result.numDeadlineMisses).paddedLeft(' ', 8)
+        + String(static_cast<double>(totalAllocations) / static_cast<double>(result.blockAllocations.size()), 2).paddedLeft(' ', 10)
+        + String(maxAllocations).paddedLeft(' ', 8);
+
+    std::cout << line << std::endl;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: plugdata_bench [options] [patches...]" << std::endl
+              << "  --seconds <n>              seconds of audio to process per run (default: 10)" << std::endl
+              << "  --samplerates <a,b,...>    sample rates to test (default: 44100,48000,96000)" << std::endl
+              << "  --blocksizes <a,b,...>     host block sizes to test (default: 64,256,1024)" << std::endl
+              << "  --oversampling <n>         oversampling factor as a power of two (default: 0)" << std::endl
+              << "Without patches, the reference patches in " << PLUGDATA_BENCHMARK_PATCHES << " are used" << std::endl;
+}
+
+static bool parseArguments(StringArray const& args, BenchmarkSettings& settings)
+{
+    for (int i = 0; i < args.size(); i++) {
+        auto const& arg = args[i];
+        auto const hasValue = i + 1 < args.size();
+
+        if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (arg == "--seconds" && hasValue) {
+            settings.seconds = args[++i].getDoubleValue();
+        } else if (arg == "--samplerates" && hasValue) {
+            settings.sampleRates.clear();
+            for (auto const& sampleRate : StringArray::fromTokens(args[++i], ",", ""))
+                settings.sampleRates.add(sampleRate.getDoubleValue());
+        } else if (arg == "--blocksizes" && hasValue) {
+            settings.blockSizes.clear();
+            for (auto const& blockSize : StringArray::fromTokens(args[++i], ",", ""))
+                settings.blockSizes.add(blockSize.getIntValue());
+        } else if (arg == "--oversampling" && hasValue) {
+            settings.oversampling = jlimit(0, 3, args[++i].getIntValue());
+        } else if (arg.startsWith("--")) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else {
+            settings.patches.add(File::getCurrentWorkingDirectory().getChildFile(arg));
+        }
+    }
+
+    if (settings.patches.isEmpty()) {
+        for (auto const& patch : File(PLUGDATA_BENCHMARK_PATCHES).findChildFiles(File::findFiles, false, "*.pd"))
+            settings.patches.add(patch);
+    }
+
+    return settings.seconds > 0.0 && !settings.patches.isEmpty();
+}
+
+int main(int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    StringArray args;
+    for (int i = 1; i < argc; i++)
+        args.add(String::fromUTF8(argv[i]));
+
+    BenchmarkSettings settings;
+    if (!parseArguments(args, settings)) {
+        printUsage();
+        return 1;
+    }
+
+    std::cout << String("patch").paddedRight(' ', 16)
+              << String("rate").paddedLeft(' ', 8)
+              << String("block").paddedLeft(' ', 7)
+              << String("mean ms").paddedLeft(' ', 10)
+              << String("p50").paddedLeft(' ', 10)
+              << String("p90").paddedLeft(' ', 10)
+              << String("p99").paddedLeft(' ', 10)
+              << String("p99.9").paddedLeft(' ', 10)
+              << String("max").paddedLeft(' ', 10)
+              << String("load %").paddedLeft(' ', 8)
+              << String("misses").paddedLeft(' ', 8)
+              << String("alloc/blk").paddedLeft(' ', 10)
+              << String("max").paddedLeft(' ', 8) << std::endl;
+
+    int totalMisses = 0;
+    for (auto const& patch : settings.patches) {
+        for (auto const sampleRate : settings.sampleRates) {
+            for (auto const blockSize : settings.blockSizes) {
+                auto result = runBenchmark(patch, sampleRate, blockSize, settings);
+                printResult(patch, sampleRate, blockSize, result);
+                totalMisses += result.numDeadlineMisses;
+            }
+        }
+    }
+
+    // Non-zero exit code when any block took longer than realtime, so CI can flag regressions
+    return totalMisses > 0 ? 2 : 0;
+}
@@ -0,0 +1,39 @@
+/*
+    IMPORTANT! This file is auto-generated.
+    If you alter its contents, your changes may be overwritten!
+
+    This is the header file that your files should include in order to get all the
+    JUCE library headers. You should avoid including the JUCE headers directly in
+    your own source files, because that wouldn't pick up the correct configuration
+    options for your app.
+
+*/
+
+#pragma once
+
+#include <juce_audio_utils/juce_audio_utils.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_gui_extra/juce_gui_extra.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <juce_graphics/juce_graphics.h>
+#include <juce_events/juce_events.h>
+#include <juce_core/juce_core.h>
+#include <juce_data_structures/juce_data_structures.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_devices/juce_audio_devices.h>
+#include <juce_audio_plugin_client/juce_audio_plugin_client.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "BinaryData.h"
+
+using namespace juce;
+
+/*
+namespace ProjectInfo
+{
+    const char* const  projectName    = "PlugData";
+    const char* const  companyName    = "PlugData";
+    const char* const  versionString  = "0.5.3";
+    const int          versionNumber  =  0x503;
+} */
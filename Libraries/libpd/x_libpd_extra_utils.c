@@ -60,6 +60,275 @@ void* libpd_create_canvas(char const* name, char const* path)
     return cnv;
 }
 
+// Defined in g_canvas.c and m_pd.c
+void glob_setfilename(void* dummy, t_symbol* filesym, t_symbol* dirsym);
+void canvas_initbang(t_canvas* x);
+void pd_doloadbang(void);
+
+// Does what glob_evalfile does, but with a binbuf that was already read and tokenised
+// The binbuf is left untouched, so it can be evaluated again later
+void* libpd_create_canvas_from_binbuf(t_binbuf* b, char const* name, char const* path)
+{
+    t_pd *x = 0, *boundx, *bounda, *boundn;
+    int dspstate = canvas_suspend_dsp();
+
+    /* leave #X bound for us to grab the new canvas */
+    boundx = s__X.s_thing;
+    s__X.s_thing = 0;
+
+    /* set filename so that new canvases can pick them up */
+    glob_setfilename(0, gensym(name), gensym(path));
+
+    /* save bindings of symbols #N, #A (and restore afterward) */
+    bounda = gensym("#A")->s_thing;
+    boundn = s__N.s_thing;
+    gensym("#A")->s_thing = 0;
+    s__N.s_thing = &pd_canvasmaker;
+
+    binbuf_eval(b, 0, 0, 0);
+
+    /* avoid crashing if no canvas was created by binbuf eval */
+    if (s__X.s_thing && *s__X.s_thing == canvas_class)
+        canvas_initbang((t_canvas*)(s__X.s_thing));
+
+    gensym("#A")->s_thing = bounda;
+    s__N.s_thing = boundn;
+    glob_setfilename(0, &s_, &s_);
+
+    while ((x != s__X.s_thing) && s__X.s_thing) {
+        x = s__X.s_thing;
+        vmess(x, gensym("pop"), "i", 1);
+    }
+    if (!sys_noloadbang)
+        pd_doloadbang();
+
+    canvas_resume_dsp(dspstate);
+    s__X.s_thing = boundx;
+
+    if (x) {
+        canvas_vis((t_canvas*)x, 1.f);
+        canvas_rename((t_canvas*)x, gensym(name), gensym(path));
+    }
+
+    return x;
+}
+
+typedef struct _libpd_token {
+    t_atomtype type;
+    t_float value; // number for A_FLOAT and A_DOLLAR
+    size_t name;   // offset into the name buffer for A_SYMBOL and A_DOLLSYM
+} t_libpd_token;
+
+struct _libpd_tokens {
+    t_libpd_token* tokens;
+    int num_tokens;
+    int tokens_capacity;
+    char* names;
+    size_t names_size;
+    size_t names_capacity;
+};
+
+static void tokens_add(t_libpd_tokens* x, t_atomtype type, t_float value, char const* name)
+{
+    t_libpd_token* token;
+
+    if (x->num_tokens == x->tokens_capacity) {
+        int new_capacity = x->tokens_capacity * 2;
+        x->tokens = (t_libpd_token*)resizebytes(x->tokens, x->tokens_capacity * sizeof(t_libpd_token), new_capacity * sizeof(t_libpd_token));
+        x->tokens_capacity = new_capacity;
+    }
+
+    token = x->tokens + x->num_tokens++;
+    token->type = type;
+    token->value = value;
+    token->name = 0;
+
+    if (name) {
+        size_t length = strlen(name) + 1;
+        while (x->names_size + length > x->names_capacity) {
+            x->names = (char*)resizebytes(x->names, x->names_capacity, x->names_capacity * 2);
+            x->names_capacity *= 2;
+        }
+        memcpy(x->names + x->names_size, name, length);
+        token->name = x->names_size;
+        x->names_size += length;
+    }
+}
+
+// Same lexing as binbuf_text in m_binbuf.c, up to the point where it interns symbols
+t_libpd_tokens* libpd_tokens_new(char const* text, size_t size)
+{
+    char buf[MAXPDSTRING + 1], *bufp, *ebuf = buf + MAXPDSTRING;
+    char const *textp = text, *etext = text + size;
+    t_libpd_tokens* x = (t_libpd_tokens*)getbytes(sizeof(t_libpd_tokens));
+
+    x->tokens_capacity = 16;
+    x->tokens = (t_libpd_token*)getbytes(x->tokens_capacity * sizeof(t_libpd_token));
+    x->names_capacity = 256;
+    x->names = (char*)getbytes(x->names_capacity);
+
+    while (1) {
+        // skip leading space
+        while ((textp != etext) && (*textp == ' ' || *textp == '\n' || *textp == '\r' || *textp == '\t'))
+            textp++;
+        if (textp == etext)
+            break;
+        if (*textp == ';') {
+            tokens_add(x, A_SEMI, 0, 0);
+            textp++;
+        } else if (*textp == ',') {
+            tokens_add(x, A_COMMA, 0, 0);
+            textp++;
+        } else {
+            // it's an atom other than a comma or semi
+            char c;
+            int floatstate = 0, slash = 0, lastslash = 0, dollar = 0;
+            bufp = buf;
+            do {
+                c = *bufp = *textp++;
+                lastslash = slash;
+                slash = (c == '\\');
+
+                if (floatstate >= 0) {
+                    int digit = (c >= '0' && c <= '9'), dot = (c == '.'), minus = (c == '-'), plusminus = (minus || (c == '+')), expon = (c == 'e' || c == 'E');
+                    if (floatstate == 0) { // beginning
+                        if (minus)
+                            floatstate = 1;
+                        else if (digit)
+                            floatstate = 2;
+                        else if (dot)
+                            floatstate = 3;
+                        else
+                            floatstate = -1;
+                    } else if (floatstate == 1) { // got minus
+                        if (digit)
+                            floatstate = 2;
+                        else if (dot)
+                            floatstate = 3;
+                        else
+                            floatstate = -1;
+                    } else if (floatstate == 2) { // got digits
+                        if (dot)
+                            floatstate = 4;
+                        else if (expon)
+                            floatstate = 6;
+                        else if (!digit)
+                            floatstate = -1;
+                    } else if (floatstate == 3) { // got '.' without digits
+                        if (digit)
+                            floatstate = 5;
+                        else
+                            floatstate = -1;
+                    } else if (floatstate == 4) { // got '.' after digits
+                        if (digit)
+                            floatstate = 5;
+                        else if (expon)
+                            floatstate = 6;
+                        else
+                            floatstate = -1;
+                    } else if (floatstate == 5) { // got digits after .
+                        if (expon)
+                            floatstate = 6;
+                        else if (!digit)
+                            floatstate = -1;
+                    } else if (floatstate == 6) { // got 'e'
+                        if (plusminus)
+                            floatstate = 7;
+                        else if (digit)
+                            floatstate = 8;
+                        else
+                            floatstate = -1;
+                    } else if (floatstate == 7) { // got plus or minus
+                        if (digit)
+                            floatstate = 8;
+                        else
+                            floatstate = -1;
+                    } else if (floatstate == 8) { // got digits
+                        if (!digit)
+                            floatstate = -1;
+                    }
+                }
+                if (!lastslash && c == '$' && (textp != etext && textp[0] >= '0' && textp[0] <= '9'))
+                    dollar = 1;
+                if (!slash)
+                    bufp++;
+                else if (lastslash) {
+                    bufp++;
+                    slash = 0;
+                }
+            } while (textp != etext && bufp != ebuf && (slash || (*textp != ' ' && *textp != '\n' && *textp != '\r' && *textp != '\t' && *textp != ',' && *textp != ';')));
+            *bufp = 0;
+
+            if (floatstate == 2 || floatstate == 4 || floatstate == 5 || floatstate == 8) {
+                tokens_add(x, A_FLOAT, atof(buf), 0);
+            } else if (dollar) {
+                if (buf[0] != '$')
+                    dollar = 0;
+                for (bufp = buf + 1; *bufp; bufp++)
+                    if (*bufp < '0' || *bufp > '9')
+                        dollar = 0;
+                if (dollar)
+                    tokens_add(x, A_DOLLAR, atoi(buf + 1), 0);
+                else
+                    tokens_add(x, A_DOLLSYM, 0, buf);
+            } else {
+                tokens_add(x, A_SYMBOL, 0, buf);
+            }
+        }
+    }
+
+    return x;
+}
+
+void libpd_tokens_free(t_libpd_tokens* x)
+{
+    freebytes(x->tokens, x->tokens_capacity * sizeof(t_libpd_token));
+    freebytes(x->names, x->names_capacity);
+    freebytes(x, sizeof(t_libpd_tokens));
+}
+
+size_t libpd_tokens_get_size(t_libpd_tokens* x)
+{
+    return sizeof(t_libpd_tokens) + x->tokens_capacity * sizeof(t_libpd_token) + x->names_capacity;
+}
+
+t_binbuf* libpd_tokens_to_binbuf(t_libpd_tokens* x)
+{
+    t_binbuf* b = binbuf_new();
+    t_atom* atoms = (t_atom*)getbytes((x->num_tokens ? x->num_tokens : 1) * sizeof(t_atom));
+    int i;
+
+    for (i = 0; i < x->num_tokens; i++) {
+        t_libpd_token const* token = x->tokens + i;
+        switch (token->type) {
+        case A_FLOAT:
+            SETFLOAT(atoms + i, token->value);
+            break;
+        case A_DOLLAR:
+            SETDOLLAR(atoms + i, (int)token->value);
+            break;
+        case A_DOLLSYM:
+            SETDOLLSYM(atoms + i, gensym(x->names + token->name));
+            break;
+        case A_SEMI:
+            SETSEMI(atoms + i);
+            break;
+        case A_COMMA:
+            SETCOMMA(atoms + i);
+            break;
+        default:
+            SETSYMBOL(atoms + i, gensym(x->names + token->name));
+            break;
+        }
+    }
+
+    // binbuf_add copies the atoms as they are, unlike binbuf_restore it doesn't look for dollars in symbols again
+    binbuf_add(b, x->num_tokens, atoms);
+    freebytes(atoms, (x->num_tokens ? x->num_tokens : 1) * sizeof(t_atom));
+
+    return b;
+}
+
 char const* libpd_get_object_class_name(void* ptr)
 {
     return class_getname(pd_class((t_pd*)ptr));
@@ -315,6 +584,32 @@ int libpd_process_nodsp(void)
     PROCESS_NODSP()
 }
 
+int libpd_process_channels(float const* const* inputs, int nins, float* const* outputs, int nouts, int offset, t_libpd_profiler* profiler)
+{
+    int const n_in = STUFF->st_inchannels;
+    int const n_out = STUFF->st_outchannels;
+    int ch;
+
+    sys_lock();
+    sys_pollgui();
+    for (ch = 0; ch < n_in; ch++) {
+        if (ch < nins) {
+            memcpy(STUFF->st_soundin + ch * DEFDACBLKSIZE, inputs[ch] + offset, DEFDACBLKSIZE * sizeof(t_sample));
+        } else {
+            memset(STUFF->st_soundin + ch * DEFDACBLKSIZE, 0, DEFDACBLKSIZE * sizeof(t_sample));
+        }
+    }
+    memset(STUFF->st_soundout, 0, n_out * DEFDACBLKSIZE * sizeof(t_sample));
+    if (profiler)
+        libpd_profiler_arm(profiler);
+    sched_tick();
+    for (ch = 0; ch < n_out && ch < nouts; ch++) {
+        memcpy(outputs[ch] + offset, STUFF->st_soundout + ch * DEFDACBLKSIZE, DEFDACBLKSIZE * sizeof(t_sample));
+    }
+    sys_unlock();
+    return 0;
+}
+
 int libpd_is_text_object(void* obj)
 {
     return ((t_gobj*)obj)->g_pd->c_wb == &text_widgetbehavior;
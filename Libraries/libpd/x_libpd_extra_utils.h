@@ -12,9 +12,22 @@ extern "C" {
 #endif
 #include <m_pd.h>
 #include "z_libpd.h"
+#include "x_libpd_profiler.h"
 
 void* libpd_create_canvas(char const* name, char const* path);
 
+// create a canvas from a tokenised patch file, call with the pd lock held
+void* libpd_create_canvas_from_binbuf(t_binbuf* b, char const* name, char const* path);
+
+// patch text that was split up the way binbuf_text does it, but without interning any symbols yet
+// creating and freeing tokens doesn't need the pd lock, so it can happen on any thread
+typedef struct _libpd_tokens t_libpd_tokens;
+t_libpd_tokens* libpd_tokens_new(char const* text, size_t size);
+void libpd_tokens_free(t_libpd_tokens* tokens);
+size_t libpd_tokens_get_size(t_libpd_tokens* tokens);
+// interns the symbols and returns a new binbuf, call with the pd lock held
+t_binbuf* libpd_tokens_to_binbuf(t_libpd_tokens* tokens);
+
 char const* libpd_get_object_class_name(void* ptr);
 void libpd_get_object_text(void* ptr, char** text, int* size);
 void libpd_get_object_bounds(void* patch, void* ptr, int* x, int* y, int* w, int* h);
@@ -62,6 +75,11 @@ float libpd_get_canvas_font_height(t_canvas* cnv);
 
 int libpd_process_nodsp(void);
 
+// process one pd tick, reading and writing straight from separate channel buffers starting at offset
+// inputs and outputs may point to the same buffers, all input is consumed before output is written
+// when a profiler is passed, the DSP chain of this tick gets timed per perform routine
+int libpd_process_channels(float const* const* inputs, int nins, float* const* outputs, int nouts, int offset, t_libpd_profiler* profiler);
+
 unsigned int convert_from_iem_color(const int color);
 unsigned int convert_to_iem_color(char const* hex);
 
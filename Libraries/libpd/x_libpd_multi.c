@@ -12,6 +12,8 @@
 #include <string.h>
 #include <assert.h>
 #include "x_libpd_multi.h"
+#include "x_libpd_playhead.h"
+#include "x_libpd_notein_tilde.h"
 
 
 static t_class* libpd_multi_receiver_class;
@@ -1251,6 +1253,8 @@ void libpd_multi_init(void)
         libpd_multi_receiver_setup();
         libpd_multi_midi_setup();
         libpd_multi_print_setup();
+        libpd_playhead_setup();
+        libpd_notein_tilde_setup();
         libpd_defaultfont_init();
         libpd_set_verbose(4);
 
@@ -0,0 +1,167 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <string.h>
+
+#include <m_pd.h>
+
+#include "x_libpd_notein_tilde.h"
+
+#define NOTEIN_TILDE_MAXEVENTS 256
+
+// [notein~]: sample accurate version of [notein], outputs the pitch and velocity of the last note as signals
+static t_class* libpd_notein_tilde_class;
+
+typedef struct _notein_tilde_event {
+    double time; // in samples at pd's sample rate, on the same clock as clock_gettimesincewithunits
+    t_sample pitch;
+    t_sample velocity;
+} t_notein_tilde_event;
+
+typedef struct _libpd_notein_tilde {
+    t_object x_obj;
+    t_pdinstance* x_instance;
+    struct _libpd_notein_tilde* x_next;
+    int x_channel; // 0 for omni
+    t_sample x_pitch;
+    t_sample x_velocity;
+    double x_scale;    // samples at pd's sample rate per sample of our block, for up- and downsampled subpatches
+    double x_hop;      // time between two blocks, in samples at pd's sample rate
+    double x_lasttick; // end of the tick that we last ran in
+    int x_run;         // blocks that are shorter than a tick run several times in a row within it
+    int x_numdropped;
+    int x_numevents;
+    t_notein_tilde_event x_events[NOTEIN_TILDE_MAXEVENTS]; // events that haven't been output yet, sorted by time
+} t_libpd_notein_tilde;
+
+// All [notein~] objects of all instances, only touched while holding the pd lock
+static t_libpd_notein_tilde* libpd_notein_tilde_list;
+
+static t_int* libpd_notein_tilde_perform(t_int* w)
+{
+    t_libpd_notein_tilde* x = (t_libpd_notein_tilde*)(w[1]);
+    t_sample* pitch_out = (t_sample*)(w[2]);
+    t_sample* velocity_out = (t_sample*)(w[3]);
+    int n = (int)(w[4]);
+    int i, event = 0;
+    double now = clock_gettimesincewithunits(0, 1, 1); // end of the current tick
+    double start, end;
+
+    if (now != x->x_lasttick) {
+        x->x_lasttick = now;
+        x->x_run = 0;
+    } else {
+        x->x_run++;
+    }
+
+    // Find the stretch of time that this block covers, blocks that are a tick or longer end with the tick
+    end = x->x_hop < sys_getblksize() ? now - sys_getblksize() + (x->x_run + 1) * x->x_hop : now;
+    start = end - n * x->x_scale;
+
+    for (i = 0; i < n; i++) {
+        double time = start + i * x->x_scale;
+        while (event < x->x_numevents && x->x_events[event].time <= time) {
+            x->x_pitch = x->x_events[event].pitch;
+            x->x_velocity = x->x_events[event].velocity;
+            event++;
+        }
+        pitch_out[i] = x->x_pitch;
+        velocity_out[i] = x->x_velocity;
+    }
+
+    // Events that fall between our last sample and the end of the block still get applied, at the end
+    for (; event < x->x_numevents && x->x_events[event].time < end; event++) {
+        x->x_pitch = x->x_events[event].pitch;
+        x->x_velocity = x->x_events[event].velocity;
+    }
+
+    // The rest belongs to a later block, which can be a few ticks away in a reblocked subpatch
+    memmove(x->x_events, x->x_events + event, (x->x_numevents - event) * sizeof(t_notein_tilde_event));
+    x->x_numevents -= event;
+
+    if (x->x_numdropped) {
+        pd_error(x, "notein~: dropped %d notes, too many arrived within one block", x->x_numdropped);
+        x->x_numdropped = 0;
+    }
+
+    return (w + 5);
+}
+
+static void libpd_notein_tilde_dsp(t_libpd_notein_tilde* x, t_signal** sp)
+{
+    x->x_scale = sys_getsr() / sp[0]->s_sr;
+    x->x_hop = sp[0]->s_n / sp[0]->s_overlap * x->x_scale;
+    x->x_lasttick = -1;
+    x->x_run = 0;
+    dsp_add(libpd_notein_tilde_perform, 4, x, sp[0]->s_vec, sp[1]->s_vec, (t_int)sp[0]->s_n);
+}
+
+static void* libpd_notein_tilde_new(t_floatarg channel)
+{
+    t_libpd_notein_tilde* x = (t_libpd_notein_tilde*)pd_new(libpd_notein_tilde_class);
+
+    outlet_new(&x->x_obj, &s_signal);
+    outlet_new(&x->x_obj, &s_signal);
+
+    x->x_channel = channel > 0 ? (int)channel : 0;
+    x->x_pitch = 0;
+    x->x_velocity = 0;
+    x->x_scale = 1;
+    x->x_hop = sys_getblksize();
+    x->x_lasttick = -1;
+    x->x_run = 0;
+    x->x_numdropped = 0;
+    x->x_numevents = 0;
+
+    x->x_instance = pd_this;
+    x->x_next = libpd_notein_tilde_list;
+    libpd_notein_tilde_list = x;
+
+    return x;
+}
+
+static void libpd_notein_tilde_free(t_libpd_notein_tilde* x)
+{
+    t_libpd_notein_tilde** y;
+    for (y = &libpd_notein_tilde_list; *y; y = &(*y)->x_next) {
+        if (*y == x) {
+            *y = x->x_next;
+            break;
+        }
+    }
+}
+
+void libpd_notein_tilde_setup(void)
+{
+    libpd_notein_tilde_class = class_new(gensym("notein~"), (t_newmethod)libpd_notein_tilde_new, (t_method)libpd_notein_tilde_free,
+        sizeof(t_libpd_notein_tilde), CLASS_NOINLET, A_DEFFLOAT, A_NULL);
+    class_addmethod(libpd_notein_tilde_class, (t_method)libpd_notein_tilde_dsp, gensym("dsp"), A_CANT, A_NULL);
+}
+
+void libpd_notein_tilde(int channel, int pitch, int velocity, int offset)
+{
+    t_libpd_notein_tilde* x;
+
+    sys_lock();
+    for (x = libpd_notein_tilde_list; x; x = x->x_next) {
+        t_notein_tilde_event* event;
+        if (x->x_instance != pd_this || (x->x_channel && x->x_channel != channel))
+            continue;
+
+        // When a block gets more notes than we can hold, the latest ones win
+        if (x->x_numevents == NOTEIN_TILDE_MAXEVENTS) {
+            x->x_numevents--;
+            x->x_numdropped++;
+        }
+
+        // The tick that the offset is in starts at the current logical time
+        event = x->x_events + x->x_numevents++;
+        event->time = clock_gettimesincewithunits(0, 1, 1) + offset;
+        event->pitch = pitch;
+        event->velocity = velocity;
+    }
+    sys_unlock();
+}
@@ -0,0 +1,25 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+
+extern "C" {
+#endif
+
+#include <m_pd.h>
+
+void libpd_notein_tilde_setup(void);
+
+// passes a note to all [notein~] objects in the current instance, offset is the sample within the next DSP tick
+// objects in reblocked or resampled subpatches output it at the matching sample of their own blocks
+// a velocity of 0 is a note off
+void libpd_notein_tilde(int channel, int pitch, int velocity, int offset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <m_pd.h>
+
+#include "x_libpd_playhead.h"
+
+#define PLAYHEAD_NOUTLETS 9
+
+static t_class* libpd_playhead_class;
+
+typedef struct _libpd_playhead {
+    t_object x_obj;
+    t_pdinstance* x_instance;
+    struct _libpd_playhead* x_next;
+    t_libpd_playhead_state x_state; // last state we received, for banging
+    t_outlet* x_outlets[PLAYHEAD_NOUTLETS];
+} t_libpd_playhead;
+
+// All [playhead] objects of all instances, only touched while holding the pd lock
+static t_libpd_playhead* libpd_playhead_list;
+
+static void libpd_playhead_output(t_libpd_playhead* x, int changed)
+{
+    t_libpd_playhead_state const* state = &x->x_state;
+    t_atom atoms[3];
+
+    // Right to left, like every other pd object
+    if (changed & LIBPD_PLAYHEAD_POSITION) {
+        SETFLOAT(atoms, state->ppq);
+        SETFLOAT(atoms + 1, state->samples);
+        SETFLOAT(atoms + 2, state->seconds);
+        outlet_list(x->x_outlets[8], &s_list, 3, atoms);
+    }
+    if (changed & LIBPD_PLAYHEAD_TIMESIG) {
+        SETFLOAT(atoms, state->timesig_numerator);
+        SETFLOAT(atoms + 1, state->timesig_denominator);
+        outlet_list(x->x_outlets[7], &s_list, 2, atoms);
+    }
+    if (changed & LIBPD_PLAYHEAD_LASTBAR)
+        outlet_float(x->x_outlets[6], state->lastbar);
+    if (changed & LIBPD_PLAYHEAD_BPM)
+        outlet_float(x->x_outlets[5], state->bpm);
+    if (changed & LIBPD_PLAYHEAD_FRAMERATE)
+        outlet_float(x->x_outlets[4], state->framerate);
+    if (changed & LIBPD_PLAYHEAD_EDITTIME)
+        outlet_float(x->x_outlets[3], state->edittime);
+    if (changed & LIBPD_PLAYHEAD_LOOPING) {
+        SETFLOAT(atoms, state->looping);
+        SETFLOAT(atoms + 1, state->loop_start);
+        SETFLOAT(atoms + 2, state->loop_end);
+        outlet_list(x->x_outlets[2], &s_list, 3, atoms);
+    }
+    if (changed & LIBPD_PLAYHEAD_RECORDING)
+        outlet_float(x->x_outlets[1], state->recording);
+    if (changed & LIBPD_PLAYHEAD_PLAYING)
+        outlet_float(x->x_outlets[0], state->playing);
+}
+
+static void libpd_playhead_bang(t_libpd_playhead* x)
+{
+    libpd_playhead_output(x, LIBPD_PLAYHEAD_ALL);
+}
+
+static void* libpd_playhead_new(void)
+{
+    int i;
+    t_libpd_playhead* x = (t_libpd_playhead*)pd_new(libpd_playhead_class);
+
+    for (i = 0; i < PLAYHEAD_NOUTLETS; i++)
+        x->x_outlets[i] = outlet_new(&x->x_obj, 0);
+
+    x->x_instance = pd_this;
+    x->x_next = libpd_playhead_list;
+    libpd_playhead_list = x;
+
+    return x;
+}
+
+static void libpd_playhead_free(t_libpd_playhead* x)
+{
+    t_libpd_playhead** y;
+    for (y = &libpd_playhead_list; *y; y = &(*y)->x_next) {
+        if (*y == x) {
+            *y = x->x_next;
+            break;
+        }
+    }
+}
+
+void libpd_playhead_setup(void)
+{
+    libpd_playhead_class = class_new(gensym("playhead"), (t_newmethod)libpd_playhead_new, (t_method)libpd_playhead_free,
+        sizeof(t_libpd_playhead), CLASS_DEFAULT, A_NULL);
+    class_addbang(libpd_playhead_class, libpd_playhead_bang);
+}
+
+int libpd_playhead_send(t_libpd_playhead_state const* state, int changed)
+{
+    t_libpd_playhead *x, *next;
+    int num_objects = 0;
+
+    sys_lock();
+    for (x = libpd_playhead_list; x; x = next) {
+        // The object could get deleted by something it triggers
+        next = x->x_next;
+        if (x->x_instance != pd_this)
+            continue;
+
+        x->x_state = *state;
+        libpd_playhead_output(x, changed);
+        num_objects++;
+    }
+    sys_unlock();
+
+    return num_objects;
+}
@@ -0,0 +1,55 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+
+extern "C" {
+#endif
+
+#include <m_pd.h>
+
+// Everything the host tells us about its playhead
+typedef struct _libpd_playhead_state {
+    t_float playing;
+    t_float recording;
+    t_float looping;
+    t_float loop_start;
+    t_float loop_end;
+    t_float edittime;
+    t_float framerate;
+    t_float bpm;
+    t_float lastbar;
+    t_float timesig_numerator;
+    t_float timesig_denominator;
+    t_float ppq;
+    t_float samples;
+    t_float seconds;
+} t_libpd_playhead_state;
+
+// Flags for the fields that changed, every flag matches one outlet of [playhead]
+enum {
+    LIBPD_PLAYHEAD_PLAYING = 1 << 0,
+    LIBPD_PLAYHEAD_RECORDING = 1 << 1,
+    LIBPD_PLAYHEAD_LOOPING = 1 << 2,
+    LIBPD_PLAYHEAD_EDITTIME = 1 << 3,
+    LIBPD_PLAYHEAD_FRAMERATE = 1 << 4,
+    LIBPD_PLAYHEAD_BPM = 1 << 5,
+    LIBPD_PLAYHEAD_LASTBAR = 1 << 6,
+    LIBPD_PLAYHEAD_TIMESIG = 1 << 7,
+    LIBPD_PLAYHEAD_POSITION = 1 << 8,
+    LIBPD_PLAYHEAD_ALL = (1 << 9) - 1
+};
+
+void libpd_playhead_setup(void);
+
+// outputs the changed fields from all [playhead] objects in the current instance, returns how many there are
+int libpd_playhead_send(t_libpd_playhead_state const* state, int changed);
+
+#ifdef __cplusplus
+}
+#endif
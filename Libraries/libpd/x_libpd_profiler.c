@@ -0,0 +1,245 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <string.h>
+
+#include <m_pd.h>
+#include <m_imp.h>
+
+#if defined(_WIN32)
+#    include <windows.h>
+#elif defined(__APPLE__)
+#    include <mach/mach_time.h>
+#else
+#    include <time.h>
+#endif
+
+#include "x_libpd_profiler.h"
+
+// Only the first two fields matter to us, the rest of the struct is private to d_ugen.c
+struct _fake_instanceugen {
+    t_int* u_dspchain;
+    int u_dspchainsize;
+};
+
+struct _libpd_profiler {
+    t_perfroutine first;     // perform routine that we replaced at the start of the chain
+    unsigned long hash;      // contents of the chain that the results belong to
+    unsigned int generation; // goes up every time the chain changes
+    t_int* chain;            // start of the chain that is being profiled
+    int chain_size;
+    int capacity;            // only ever changed by libpd_profiler_reserve
+    int wanted_capacity;     // size of the last chain that didn't fit
+    t_int** entries;         // indexed by offset into the chain, null for fields that aren't the start of an entry
+    double* times;           // indexed the same way
+    int num_ticks;
+};
+
+// The profiler that belongs to the tick that is currently running on this thread
+static PERTHREAD t_libpd_profiler* current_profiler;
+
+static double profiler_now(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (!frequency.QuadPart)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)frequency.QuadPart;
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+    if (!timebase.denom)
+        mach_timebase_info(&timebase);
+    return (double)mach_absolute_time() * timebase.numer / timebase.denom * 1e-9;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+static void profiler_reset(t_libpd_profiler* x)
+{
+    if (x->capacity) {
+        memset(x->entries, 0, x->capacity * sizeof(t_int*));
+        memset(x->times, 0, x->capacity * sizeof(double));
+    }
+    x->num_ticks = 0;
+}
+
+static unsigned long profiler_hash(unsigned long hash, t_int value)
+{
+    return (hash ^ (unsigned long)value) * 16777619UL;
+}
+
+// Sits at the start of the chain in place of the first perform routine
+// Runs the whole chain itself, timing every entry, and then ends dsp_tick's loop by returning 0
+static t_int* profiler_perform(t_int* w)
+{
+    t_libpd_profiler* x = current_profiler;
+
+    w[0] = (t_int)x->first;
+
+    // Reblocked subpatches jump back into the chain, so an entry can run several times per tick
+    // Results are stored by offset into the chain, repeated runs add up in the same slot
+    while (w) {
+        double start = profiler_now();
+        t_int* next = (*(t_perfroutine)(*w))(w);
+        double time = profiler_now() - start;
+        long offset = (long)(w - x->chain);
+
+        if (offset >= 0 && offset < x->chain_size) {
+            x->entries[offset] = w;
+            x->times[offset] += time;
+        }
+
+        w = next;
+    }
+
+    x->num_ticks++;
+
+    return 0;
+}
+
+t_libpd_profiler* libpd_profiler_new(void)
+{
+    t_libpd_profiler* x = (t_libpd_profiler*)getbytes(sizeof(t_libpd_profiler));
+    return x;
+}
+
+void libpd_profiler_free(t_libpd_profiler* x)
+{
+    if (x->capacity) {
+        freebytes(x->entries, x->capacity * sizeof(t_int*));
+        freebytes(x->times, x->capacity * sizeof(double));
+    }
+    freebytes(x, sizeof(t_libpd_profiler));
+}
+
+void libpd_profiler_arm(t_libpd_profiler* x)
+{
+    t_int* chain = ((struct _fake_instanceugen*)pd_this->pd_ugen)->u_dspchain;
+    int chain_size = ((struct _fake_instanceugen*)pd_this->pd_ugen)->u_dspchainsize;
+    unsigned long hash = 2166136261UL;
+    int i;
+
+    if (!chain || !pd_this->pd_dspstate)
+        return;
+
+    // We're on the audio thread, so leave it to libpd_profiler_reserve to make room and skip this tick
+    if (chain_size > x->capacity) {
+        x->wanted_capacity = chain_size;
+        return;
+    }
+
+    // A chain that was rebuilt can end up at the same address, so look at what's in it instead:
+    // the perform routines and their arguments, which are mostly objects and signal vectors
+    for (i = 0; i < chain_size; i++)
+        hash = profiler_hash(hash, chain[i]);
+
+    // The chain was rebuilt since we last looked, previous results don't apply anymore
+    if (hash != x->hash || chain != x->chain || chain_size != x->chain_size) {
+        profiler_reset(x);
+        x->hash = hash;
+        x->chain = chain;
+        x->chain_size = chain_size;
+        x->generation++;
+    }
+
+    x->first = (t_perfroutine)chain[0];
+    chain[0] = (t_int)profiler_perform;
+    current_profiler = x;
+}
+
+void libpd_profiler_reserve(t_libpd_profiler* x)
+{
+    int wanted_capacity, old_capacity;
+    t_int **entries, **old_entries;
+    double *times, *old_times;
+
+    sys_lock();
+    wanted_capacity = x->wanted_capacity;
+    sys_unlock();
+
+    if (wanted_capacity <= x->capacity)
+        return;
+
+    // Allocate without holding the lock, the audio thread only needs it for swapping the buffers
+    wanted_capacity *= 2;
+    entries = (t_int**)getbytes(wanted_capacity * sizeof(t_int*));
+    times = (double*)getbytes(wanted_capacity * sizeof(double));
+
+    sys_lock();
+    old_entries = x->entries;
+    old_times = x->times;
+    old_capacity = x->capacity;
+    x->entries = entries;
+    x->times = times;
+    x->capacity = wanted_capacity;
+    x->chain = 0;
+    x->chain_size = 0;
+    x->num_ticks = 0;
+    sys_unlock();
+
+    if (old_capacity) {
+        freebytes(old_entries, old_capacity * sizeof(t_int*));
+        freebytes(old_times, old_capacity * sizeof(double));
+    }
+}
+
+static void profiler_read_entry(t_libpd_profiler* x, t_libpd_profiler_entry* entry, int offset, int next_offset)
+{
+    t_int* w = x->entries[offset];
+    int i;
+
+    // The number of arguments is the distance to the next entry, the last entry (dsp_done) has none
+    entry->num_args = next_offset >= 0 ? next_offset - offset - 1 : 0;
+    if (entry->num_args > LIBPD_PROFILER_MAX_ARGS)
+        entry->num_args = LIBPD_PROFILER_MAX_ARGS;
+
+    for (i = 0; i < entry->num_args; i++)
+        entry->args[i] = w[i + 1];
+
+    entry->time = x->num_ticks ? x->times[offset] / x->num_ticks : 0;
+}
+
+int libpd_profiler_read(t_libpd_profiler* x, t_libpd_profiler_entry* entries, int max_entries, int reset, unsigned int* generation)
+{
+    int offset, previous = -1, num_entries = 0;
+
+    sys_lock();
+
+    // Entries that didn't run, like the ones in a switched off subpatch, have no slot and count as arguments of the one before
+    for (offset = 0; offset < x->chain_size; offset++) {
+        if (!x->entries[offset])
+            continue;
+
+        if (previous >= 0) {
+            if (num_entries < max_entries)
+                profiler_read_entry(x, entries + num_entries, previous, offset);
+            num_entries++;
+        }
+
+        previous = offset;
+    }
+
+    if (previous >= 0) {
+        if (num_entries < max_entries)
+            profiler_read_entry(x, entries + num_entries, previous, -1);
+        num_entries++;
+    }
+
+    if (generation)
+        *generation = x->generation;
+
+    if (reset)
+        profiler_reset(x);
+
+    sys_unlock();
+
+    return num_entries;
+}
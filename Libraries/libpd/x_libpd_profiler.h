@@ -0,0 +1,46 @@
+/*
+ // Copyright (c) 2015-2018 Pierre Guillot.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+
+extern "C" {
+#endif
+
+#include <m_pd.h>
+
+// Per-instance DSP profiler: times every perform routine in the DSP chain on the ticks it gets armed for
+typedef struct _libpd_profiler t_libpd_profiler;
+
+#define LIBPD_PROFILER_MAX_ARGS 8
+
+typedef struct _libpd_profiler_entry {
+    t_int args[LIBPD_PROFILER_MAX_ARGS]; // first arguments that were passed to the perform routine
+    int num_args;
+    double time; // average time per profiled tick, in seconds
+} t_libpd_profiler_entry;
+
+t_libpd_profiler* libpd_profiler_new(void);
+void libpd_profiler_free(t_libpd_profiler* profiler);
+
+// makes the next DSP tick of the current instance run through the profiler
+// must be called with the pd lock held, right before sched_tick
+// never allocates: ticks are skipped until libpd_profiler_reserve made room for the current chain
+void libpd_profiler_arm(t_libpd_profiler* profiler);
+
+// makes room for the chain that the last armed tick had to skip
+// must be called from a single thread that isn't the audio thread, without the pd lock held
+void libpd_profiler_reserve(t_libpd_profiler* profiler);
+
+// copies the results for up to max_entries chain entries and returns the number of entries in the chain
+// results are averaged over all profiled ticks since the last reset
+// generation, if not null, receives a number that changes every time the chain gets rebuilt
+int libpd_profiler_read(t_libpd_profiler* profiler, t_libpd_profiler_entry* entries, int max_entries, int reset, unsigned int* generation);
+
+#ifdef __cplusplus
+}
+#endif
@@ -73,7 +73,6 @@ globCopy("../../Libraries/pure-data/extra/*.pd", "./Abstractions")
 globCopy("../../Libraries/pure-data/extra/**/*-help.pd", "./Abstractions")
 
 globCopy("../../Libraries/ELSE/Abstractions/*.pd", "./Abstractions/else")
-copyFile("../Patches/playhead.pd", "./Abstractions")
 copyFile("../Patches/param.pd", "./Abstractions")
 #copyFile("../Patches/beat.pd", "./Abstractions")
 
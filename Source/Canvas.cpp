@@ -16,6 +16,9 @@
 #include "Utility/GraphArea.h"
 #include "Utility/RateReducer.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 extern "C" {
 void canvas_setgraph(t_glist* x, int flag, int nogoprect);
 }
@@ -24,7 +27,10 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch& p, Component* parentGraph)
     : editor(parent)
     , pd(parent->pd)
     , patch(p)
+    , renderer(new CanvasRenderer(this))
     , pathUpdater(new ConnectionPathUpdater(this))
+    , router(new ConnectionRouter(this))
+    , connectionLayer(new ConnectionLayer(this))
 {
     isGraphChild = glist_isgraph(p.getPointer());
     hideNameAndArgs = static_cast<bool>(p.getPointer()->gl_hidetext);
@@ -67,10 +73,20 @@ Canvas::Canvas(PluginEditor* parent, pd::Patch& p, Component* parentGraph)
 
     setSize(600, 400);
 
+    // Draws plain text objects behind all object components, if enabled
+    if (renderer->isEnabled()) {
+        addAndMakeVisible(renderer.get());
+        renderer->toBack();
+    }
+
     // Add lasso component
     addAndMakeVisible(&lasso);
     lasso.setAlwaysOnTop(true);
 
+    // All connections get drawn by this layer, above the objects unless we're locked
+    addAndMakeVisible(connectionLayer.get());
+    connectionLayer->setAlwaysOnTop(true);
+
     setWantsKeyboardFocus(true);
 
     if (!isGraph) {
@@ -158,6 +174,18 @@ void Canvas::paint(Graphics& g)
     }
 }
 
+void Canvas::resized()
+{
+    renderer->setBounds(getLocalBounds());
+    connectionLayer->setBounds(getLocalBounds());
+}
+
+void Canvas::childrenChanged()
+{
+    // Objects that get added, removed or brought to the front can change what the renderer is allowed to draw
+    renderer->invalidateOcclusion();
+}
+
 TabComponent* Canvas::getTabbar()
 {
     auto* leftTabbar = editor->splitView.getLeftTabbar();
@@ -218,10 +246,24 @@ void Canvas::synchronise(bool updatePosition)
     patch.setCurrent();
 
     auto pdObjects = patch.getObjects();
+    auto pdConnections = patch.getConnections();
+
+    // Index everything by pointer once, so the rest of this is linear in the size of the patch
+    std::unordered_map<void*, size_t> pdObjectIndices;
+    pdObjectIndices.reserve(pdObjects.size());
+    for (size_t i = 0; i < pdObjects.size(); i++) {
+        pdObjectIndices[pdObjects[i]] = i;
+    }
+
+    std::unordered_set<void*> pdConnectionPointers;
+    pdConnectionPointers.reserve(pdConnections.size());
+    for (auto& connection : pdConnections) {
+        pdConnectionPointers.insert(std::get<0>(connection));
+    }
 
     // Remove deleted connections
     for (int n = connections.size() - 1; n >= 0; n--) {
-        if(patch.connectionWasDeleted(connections[n]->getPointer())) {
+        if (!pdConnectionPointers.count(connections[n]->getPointer())) {
             connections.remove(n);
         }
     }
@@ -229,93 +271,113 @@ void Canvas::synchronise(bool updatePosition)
     // Remove deleted objects
     for (int n = objects.size() - 1; n >= 0; n--) {
         auto* object = objects[n];
-        if (object->gui && patch.objectWasDeleted(object->getPointer())) {
+        if (object->gui && !pdObjectIndices.count(object->getPointer())) {
             setSelected(object, false);
             objects.remove(n);
         }
     }
 
-    for (auto* object : pdObjects) {
-        auto* it = std::find_if(objects.begin(), objects.end(), [&object](Object* b) { return b->getPointer() && b->getPointer() == object; });
+    std::unordered_map<void*, Object*> objectsByPointer;
+    objectsByPointer.reserve(objects.size());
+    for (auto* object : objects) {
+        if (object->getPointer())
+            objectsByPointer[object->getPointer()] = object;
+    }
 
-        if (it == objects.end()) {
-            auto* newBox = objects.add(new Object(object, this));
-            newBox->toFront(false);
+    bool orderChanged = false;
+    for (auto* pdObject : pdObjects) {
+        auto it = objectsByPointer.find(pdObject);
 
-            // TODO: don't do this on Canvas!!
-            if (newBox->gui && newBox->gui->getLabel())
-                newBox->gui->getLabel()->toFront(false);
+        if (it == objectsByPointer.end()) {
+            auto* newBox = objects.add(new Object(pdObject, this));
+            objectsByPointer[pdObject] = newBox;
+            orderChanged = true;
         } else {
-            auto* object = *it;
+            auto* object = it->second;
 
-            // Check if number of inlets/outlets is correct
-            object->updateIolets();
+            // Check if number of inlets/outlets is correct, this is expensive so only do it if anything changed
+            if (object->ioletsNeedUpdate())
+                object->updateIolets();
 
             if (updatePosition)
                 object->updateBounds();
-
-            object->toFront(false);
-            if (object->gui && object->gui->getLabel())
-                object->gui->getLabel()->toFront(false);
         }
     }
 
     // Make sure objects have the same order
-    std::sort(objects.begin(), objects.end(),
-        [&pdObjects](Object* first, Object* second) mutable {
-            size_t idx1 = std::find(pdObjects.begin(), pdObjects.end(), first->getPointer()) - pdObjects.begin();
-            size_t idx2 = std::find(pdObjects.begin(), pdObjects.end(), second->getPointer()) - pdObjects.begin();
+    auto getPdIndex = [&pdObjectIndices](Object* object) {
+        auto it = pdObjectIndices.find(object->getPointer());
+        return it != pdObjectIndices.end() ? it->second : std::numeric_limits<size_t>::max();
+    };
+
+    orderChanged = orderChanged || !std::is_sorted(objects.begin(), objects.end(), [&getPdIndex](Object* first, Object* second) { return getPdIndex(first) < getPdIndex(second); });
 
-            return idx1 < idx2;
+    if (orderChanged) {
+        std::stable_sort(objects.begin(), objects.end(), [&getPdIndex](Object* first, Object* second) {
+            return getPdIndex(first) < getPdIndex(second);
         });
 
-    auto pdConnections = patch.getConnections();
+        // Only restack from the first object that is out of place, bringing everything to the front is slow for large patches
+        std::unordered_map<Component*, int> zOrder;
+        for (int i = 0; i < getNumChildComponents(); i++) {
+            zOrder[getChildComponent(i)] = i;
+        }
+
+        int firstOutOfOrder = objects.size();
+        for (int i = 0; i < objects.size(); i++) {
+            auto const index = zOrder.find(objects[i]);
+            if (index == zOrder.end() || (i > 0 && index->second < zOrder[objects[i - 1]])) {
+                firstOutOfOrder = i;
+                break;
+            }
+        }
+
+        for (int i = std::max(firstOutOfOrder - 1, 0); i < objects.size(); i++) {
+            auto* object = objects[i];
+            object->toFront(false);
+
+            // TODO: don't do this on Canvas!!
+            if (object->gui && object->gui->getLabel())
+                object->gui->getLabel()->toFront(false);
+        }
+    }
+
+    std::unordered_map<void*, Connection*> connectionsByPointer;
+    connectionsByPointer.reserve(connections.size());
+    for (auto* connection : connections) {
+        connectionsByPointer[connection->getPointer()] = connection;
+    }
 
     for (auto& connection : pdConnections) {
         auto& [ptr, inno, inobj, outno, outobj] = connection;
 
-        Iolet* inlet = nullptr, *outlet = nullptr;
-        
+        Iolet *inlet = nullptr, *outlet = nullptr;
+
         // Find the objects that this connection is connected to
-        for(auto* obj : objects) {
-            if(outobj && outobj == obj->getPointer()) {
-                
-                // Check if we have enough outlets, should never return false
-                if(isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
-                    outlet = obj->iolets[obj->numInputs + outno];
-                }
-                else {
-                    break;
-                }
+        // Check if we have enough iolets, should never fail
+        if (auto it = objectsByPointer.find(outobj); it != objectsByPointer.end()) {
+            auto* obj = it->second;
+            if (isPositiveAndBelow(obj->numInputs + outno, obj->iolets.size())) {
+                outlet = obj->iolets[obj->numInputs + outno];
             }
-            if(inobj && inobj == obj->getPointer()) {
-                
-                // Check if we have enough inlets, should never return false
-                if(isPositiveAndBelow(inno, obj->iolets.size())) {
-                    inlet = obj->iolets[inno];
-                }
-                else {
-                    break;
-                }
+        }
+        if (auto it = objectsByPointer.find(inobj); it != objectsByPointer.end()) {
+            auto* obj = it->second;
+            if (isPositiveAndBelow(inno, obj->iolets.size())) {
+                inlet = obj->iolets[inno];
             }
         }
-                
+
         // This shouldn't be necessary, but just to be sure...
         if (!inlet || !outlet) {
             jassertfalse;
             continue;
         }
 
-        auto* it = std::find_if(connections.begin(), connections.end(),
-                    [c_ptr = ptr](auto* c) {
-                        return c_ptr == c->getPointer();
-                    });
-
-        if (it == connections.end()) {
+        if (auto it = connectionsByPointer.find(ptr); it == connectionsByPointer.end()) {
             connections.add(new Connection(this, inlet, outlet, ptr));
         } else {
-            auto& c = *(*it);
-            c.popPathState();
+            it->second->popPathState();
         }
     }
 
@@ -1069,13 +1131,22 @@ void Canvas::valueChanged(Value& v)
 
         // move all connections to back when canvas is locked
         if (locked == var(true)) {
+            // The renderer stands in for objects, so it goes behind them but in front of the connections
+            renderer->toBack();
+
             // use reverse order to preserve correct connection layering
             for (int i = connections.size() - 1; i >= 0; i--) {
                 connections[i]->setAlwaysOnTop(false);
                 connections[i]->toBack();
             }
+
+            connectionLayer->setAlwaysOnTop(false);
+            connectionLayer->toBack();
         } else {
             // otherwise move all connections to front
+            connectionLayer->setAlwaysOnTop(true);
+            connectionLayer->toFront(false);
+
             for (auto connection : connections) {
                 connection->setAlwaysOnTop(true);
                 connection->toFront(false);
@@ -1251,6 +1322,20 @@ void Canvas::objectMouseUp(Object* component, MouseEvent const& e)
 
         pd->waitForStateUpdate();
 
+        // Segmented connections keep their route while dragging, find new ones for the connections that moved or that the objects landed on
+        auto const movedObjects = getSelectionOfType<Object>();
+        Array<Connection*> toRoute;
+        for (auto* connection : connections) {
+            if (!connection->isSegmented())
+                continue;
+
+            auto const moved = movedObjects.contains(connection->inobj.getComponent()) || movedObjects.contains(connection->outobj.getComponent());
+            if (moved || std::any_of(movedObjects.begin(), movedObjects.end(), [connection](auto* object) { return connection->intersectsObject(object); })) {
+                toRoute.add(connection);
+            }
+        }
+        router->route(toRoute);
+
         checkBounds();
         didStartDragging = false;
     }
@@ -1507,29 +1592,35 @@ bool Canvas::setPanDragMode(bool shouldPan)
 
 void Canvas::findLassoItemsInArea(Array<WeakReference<Component>>& itemsFound, Rectangle<int> const& area)
 {
-    for (auto* object : objects) {
-        if (area.intersects(object->getBounds().reduced(Object::margin))) {
-            itemsFound.add(object);
-            setSelected(object, true, false);
-        } else if (!ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown()) {
+    auto const keepSelection = ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown();
+    auto const lassoBounds = lasso.getBounds();
+
+    // Only items that are already selected can need deselecting, so we don't have to look at everything on the canvas
+    for (auto* object : getSelectionOfType<Object>()) {
+        if (!keepSelection && !area.intersects(object->getBounds().reduced(Object::margin))) {
             setSelected(object, false, false);
         }
     }
 
-    for (auto& con : connections) {
+    for (auto* con : getSelectionOfType<Connection>()) {
         // If total bounds don't intersect, there can't be an intersection with the line
-        // This is cheaper than checking the path intersection, so do this first
-        if (!con->getBounds().intersects(lasso.getBounds())) {
+        if (!con->getBounds().intersects(lassoBounds) || (!keepSelection && !con->intersects(lassoBounds.translated(-con->getX(), -con->getY()).toFloat()))) {
             setSelected(con, false, false);
-            continue;
         }
+    }
 
+    for (auto* object : objectIndex.query(area)) {
+        if (area.intersects(object->getBounds().reduced(Object::margin))) {
+            itemsFound.add(object);
+            setSelected(object, true, false);
+        }
+    }
+
+    for (auto* con : connectionIndex.query(lassoBounds)) {
         // Check if path intersects with lasso
-        if (con->intersects(lasso.getBounds().translated(-con->getX(), -con->getY()).toFloat())) {
+        if (con->intersects(lassoBounds.translated(-con->getX(), -con->getY()).toFloat())) {
             itemsFound.add(con);
             setSelected(con, true, false);
-        } else if (!ModifierKeys::getCurrentModifiers().isAnyModifierKeyDown()) {
-            setSelected(con, false, false);
         }
     }
 }
@@ -12,13 +12,17 @@
 #include "Pd/PdPatch.h"
 #include "PluginProcessor.h"
 #include "ObjectGrid.h"
+#include "ConnectionRouter.h"
+#include "CanvasRenderer.h"
 #include "Utility/RateReducer.h"
+#include "Utility/SpatialIndex.h"
 
 class SuggestionComponent;
 struct GraphArea;
 class Iolet;
 class PluginEditor;
 class ConnectionPathUpdater;
+class ConnectionLayer;
 class ConnectionBeingCreated;
 class TabComponent;
 
@@ -40,6 +44,8 @@ public:
 
     void lookAndFeelChanged() override;
     void paint(Graphics& g) override;
+    void resized() override;
+    void childrenChanged() override;
 
     void mouseDown(MouseEvent const& e) override;
     void mouseDrag(MouseEvent const& e) override;
@@ -135,6 +141,13 @@ public:
     // Needs to be allocated before object and connection so they can deselect themselves in the destructor
     SelectedItemSet<WeakReference<Component>> selectedComponents;
 
+    // Object and connection bounds in canvas coordinates, for hit-testing without looking at every object
+    // Also needs to outlive the objects and connections, they remove themselves in the destructor
+    SpatialIndex<Object> objectIndex;
+    SpatialIndex<Connection> connectionIndex;
+    ObstacleMap obstacleMap;
+    std::unique_ptr<CanvasRenderer> renderer;
+
     OwnedArray<Object> objects;
     OwnedArray<Connection> connections;
     OwnedArray<ConnectionBeingCreated> connectionsBeingCreated;
@@ -179,6 +192,8 @@ public:
     Point<int> pastedPadding;
 
     std::unique_ptr<ConnectionPathUpdater> pathUpdater;
+    std::unique_ptr<ConnectionRouter> router;
+    std::unique_ptr<ConnectionLayer> connectionLayer;
 
 private:
     SafePointer<Object> objectSnappingInbetween;
@@ -0,0 +1,462 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "CanvasRenderer.h"
+#include "Canvas.h"
+#include "Object.h"
+#include "Iolet.h"
+#include "LookAndFeel.h"
+
+static int toTile(int coordinate, int tileSize)
+{
+    return coordinate >= 0 ? coordinate / tileSize : (coordinate - tileSize + 1) / tileSize;
+}
+
+static int64 getTileKey(int x, int y)
+{
+    return (static_cast<int64>(x) << 32) | static_cast<uint32>(y);
+}
+
+static void combineHash(uint64& seed, uint64 value)
+{
+    seed = (seed ^ value) * 0x100000001b3ull;
+}
+
+static bool isWholeNumber(float value)
+{
+    return std::abs(value - std::round(value)) < 0.001f;
+}
+
+static size_t getImageBytes(Image const& image)
+{
+    return image.isValid() ? static_cast<size_t>(image.getWidth()) * image.getHeight() * 4 : 0;
+}
+
+CanvasRenderer::CanvasRenderer(Canvas* parent)
+    : cnv(parent)
+    , enabled(SettingsFile::getInstance()->getProperty<bool>("batched_rendering"))
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+void CanvasRenderer::update(Object* object)
+{
+    if (!enabled)
+        return;
+
+    // Any object that moves can start or stop covering a batched object
+    occlusionDirty = true;
+
+    auto batchedText = object->gui ? object->gui->getBatchedText() : std::nullopt;
+    auto it = recordIndices.find(object);
+
+    if (!batchedText) {
+        if (it != recordIndices.end())
+            remove(object);
+        return;
+    }
+
+    auto oldArea = Rectangle<int>();
+    if (it == recordIndices.end()) {
+        it = recordIndices.emplace(object, records.size()).first;
+        records.push_back({ object, nullptr, {}, {}, 0, true, {}, {} });
+    } else {
+        oldArea = getDirtyArea(records[it->second]);
+    }
+
+    auto& record = records[it->second];
+    auto const bounds = object->getBounds().reduced(Object::margin);
+
+    // Laying out text is the expensive part, so only do it again if the text or the size of the box changed
+    if (record.gui != object->gui.get() || record.text != batchedText->text || record.numLines != batchedText->numLines || record.bounds.getWidth() != bounds.getWidth() || record.bounds.getHeight() != bounds.getHeight()) {
+        auto const textArea = batchedText->border.subtractedFrom(bounds.withZeroOrigin());
+        auto const scale = bounds.getWidth() < 40 ? 0.9f : 1.0f;
+
+        record.glyphs.clear();
+        record.glyphs.addFittedText(Fonts::getCurrentFont().withHeight(15), batchedText->text, textArea.getX(), textArea.getY(), textArea.getWidth(), textArea.getHeight(), Justification::centredLeft, batchedText->numLines, scale);
+    }
+
+    record.gui = object->gui.get();
+    record.bounds = bounds;
+    record.text = batchedText->text;
+    record.numLines = batchedText->numLines;
+    record.isValid = batchedText->isValid;
+
+    record.iolets.clear();
+    for (auto* iolet : object->iolets) {
+        record.iolets.push_back({ iolet, iolet->getBounds().toFloat() + object->getPosition().toFloat() });
+    }
+
+    auto const newArea = getDirtyArea(record);
+    invalidate(oldArea);
+    invalidate(newArea);
+    repaint(oldArea.getUnion(newArea));
+}
+
+void CanvasRenderer::remove(Object* object)
+{
+    auto it = recordIndices.find(object);
+    if (it == recordIndices.end())
+        return;
+
+    auto const index = it->second;
+    occlusionDirty = true;
+    invalidate(getDirtyArea(records[index]));
+    repaint(getDirtyArea(records[index]));
+
+    // Swap with the last record, so the array stays contiguous
+    if (index != records.size() - 1) {
+        records[index] = std::move(records.back());
+        recordIndices[records[index].object] = index;
+    }
+
+    records.pop_back();
+    recordIndices.erase(object);
+}
+
+bool CanvasRenderer::isBatched(Object const* object) const
+{
+    if (!enabled)
+        return false;
+
+    auto it = recordIndices.find(object);
+    if (it == recordIndices.end())
+        return false;
+
+    // While the text editor is open, the object draws itself
+    auto* gui = object->gui.get();
+    auto const& record = records[it->second];
+    return gui && record.gui == gui && !gui->isEditorShown() && !record.isOccluded;
+}
+
+bool CanvasRenderer::isCandidate(ObjectRecord const& record) const
+{
+    auto* gui = record.object->gui.get();
+    return record.object->isVisible() && gui && record.gui == gui && !gui->isEditorShown();
+}
+
+void CanvasRenderer::updateOcclusion()
+{
+    // Walk the objects from back to front, collecting the ones that draw themselves
+    // A batched object that overlaps one of those would end up behind it, so it has to draw itself too
+    SpatialIndex<Object> selfDrawn;
+    int zOrder = 0;
+
+    for (auto* child : cnv->getChildren()) {
+        auto* object = dynamic_cast<Object*>(child);
+        if (!object || !object->isVisible())
+            continue;
+
+        auto it = recordIndices.find(object);
+        if (it == recordIndices.end()) {
+            selfDrawn.update(object, object->getBounds().reduced(Object::margin));
+            continue;
+        }
+
+        auto& record = records[it->second];
+        auto const wasBatched = isBatched(object);
+
+        record.isCandidate = isCandidate(record);
+        record.isOccluded = record.isCandidate && !selfDrawn.query(record.bounds).isEmpty();
+
+        // Batched objects that overlap get drawn in z-order, so they have to be drawn again if the order changed
+        auto orderChanged = false;
+        if (record.zOrder != zOrder) {
+            for (auto* other : cnv->objectIndex.query(record.bounds)) {
+                orderChanged = orderChanged || (other != object && recordIndices.count(other));
+            }
+            record.zOrder = zOrder;
+        }
+
+        if (wasBatched != isBatched(object) || orderChanged) {
+            invalidate(getDirtyArea(record));
+            repaint(getDirtyArea(record));
+            object->repaint();
+        }
+
+        if (!isBatched(object))
+            selfDrawn.update(object, record.bounds);
+
+        zOrder++;
+    }
+
+    occlusionDirty = false;
+}
+
+Rectangle<int> CanvasRenderer::getDirtyArea(ObjectRecord const& record) const
+{
+    return record.bounds.expanded(Object::margin);
+}
+
+uint64 CanvasRenderer::getState(ObjectRecord const& record) const
+{
+    uint64 state = 0xcbf29ce484222325ull;
+    combineHash(state, isBatched(record.object));
+    combineHash(state, record.object->isVisible());
+    combineHash(state, cnv->isSelected(record.object) && !cnv->isGraph);
+
+    for (auto const& [iolet, bounds] : record.iolets) {
+        combineHash(state, iolet->isVisible());
+        combineHash(state, iolet->isSignal);
+    }
+
+    return state;
+}
+
+CanvasRenderer::Style CanvasRenderer::getStyle() const
+{
+    Style style;
+    style.background = cnv->findColour(PlugDataColour::textObjectBackgroundColourId);
+    style.ioletArea = cnv->findColour(PlugDataColour::ioletAreaColourId);
+    style.text = cnv->findColour(PlugDataColour::canvasTextColourId);
+    style.outline = cnv->findColour(PlugDataColour::objectOutlineColourId);
+    style.selectedOutline = cnv->findColour(PlugDataColour::objectSelectedOutlineColourId);
+    style.ioletOutline = cnv->findColour(PlugDataColour::ioletOutlineColourId);
+    style.signal = cnv->findColour(PlugDataColour::signalColourId);
+    style.data = cnv->findColour(PlugDataColour::dataColourId);
+    style.lockedIolet = cnv->findColour(PlugDataColour::canvasBackgroundColourId).contrasting(0.5f);
+    style.cornerRadius = PlugDataLook::objectCornerRadius;
+    style.squareIolets = PlugDataLook::getUseSquareIolets();
+    style.isLocked = static_cast<bool>(cnv->locked.getValue());
+    return style;
+}
+
+uint64 CanvasRenderer::Style::getHash() const
+{
+    uint64 result = 0xcbf29ce484222325ull;
+
+    for (auto const& colour : { background, ioletArea, text, outline, selectedOutline, ioletOutline, signal, data, lockedIolet }) {
+        combineHash(result, colour.getARGB());
+    }
+
+    combineHash(result, static_cast<uint64>(cornerRadius * 100.0f));
+    combineHash(result, squareIolets);
+    combineHash(result, isLocked);
+
+    return result;
+}
+
+void CanvasRenderer::invalidate(Rectangle<int> area)
+{
+    if (area.isEmpty() || tiles.empty())
+        return;
+
+    for (int tileX = toTile(area.getX(), tileSize); tileX <= toTile(area.getRight() - 1, tileSize); tileX++) {
+        for (int tileY = toTile(area.getY(), tileSize); tileY <= toTile(area.getBottom() - 1, tileSize); tileY++) {
+            if (auto it = tiles.find(getTileKey(tileX, tileY)); it != tiles.end()) {
+                tileBytes -= getImageBytes(it->second.image);
+                tiles.erase(it);
+            }
+        }
+    }
+}
+
+void CanvasRenderer::clearTiles()
+{
+    tiles.clear();
+    tileBytes = 0;
+}
+
+bool CanvasRenderer::canUseTiles(float scale) const
+{
+    // Dragging objects invalidates the tiles under them on every frame, so there's nothing to gain from caching
+    if (cnv->didStartDragging)
+        return false;
+
+    // Tiles only line up with device pixels if they cover a whole number of them and start on one
+    // Otherwise they'd get resampled, which blurs the text and leaves seams between tiles
+    auto const origin = localPointToGlobal(Point<float>());
+    return isWholeNumber(scale) && isWholeNumber(origin.x) && isWholeNumber(origin.y);
+}
+
+std::vector<size_t> CanvasRenderer::getRecordsInArea(Rectangle<int> area) const
+{
+    std::vector<size_t> indices;
+    for (auto* object : cnv->objectIndex.query(area)) {
+        if (auto it = recordIndices.find(object); it != recordIndices.end())
+            indices.push_back(it->second);
+    }
+
+    // Always draw in z-order, so overlapping objects look the same in every tile and the same as when they draw themselves
+    std::sort(indices.begin(), indices.end(), [this](size_t a, size_t b) { return records[a].zOrder < records[b].zOrder; });
+
+    return indices;
+}
+
+Image CanvasRenderer::renderTile(Rectangle<int> tileBounds, Style const& style) const
+{
+    auto const indices = getRecordsInArea(tileBounds);
+
+    // Empty tiles don't need an image
+    if (indices.empty())
+        return {};
+
+    auto const pixelSize = roundToInt(tileSize * tileScale);
+    auto image = Image(Image::ARGB, pixelSize, pixelSize, true);
+
+    Graphics g(image);
+    g.addTransform(AffineTransform::translation(-tileBounds.getPosition().toFloat()).scaled(pixelSize / static_cast<float>(tileSize)));
+
+    for (auto index : indices) {
+        paintRecord(g, records[index], style);
+    }
+
+    return image;
+}
+
+void CanvasRenderer::removeUnusedTiles()
+{
+    if (tileBytes <= maxTileBytes)
+        return;
+
+    // Drop the tiles that haven't been on screen for the longest time, but never the ones we just drew
+    std::vector<std::pair<uint32, int64>> candidates;
+    for (auto const& [key, tile] : tiles) {
+        if (tile.lastUsed != frameCounter)
+            candidates.emplace_back(tile.lastUsed, key);
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    for (size_t i = 0; i < candidates.size() && tileBytes > maxTileBytes; i++) {
+        auto it = tiles.find(candidates[i].second);
+        tileBytes -= getImageBytes(it->second.image);
+        tiles.erase(it);
+    }
+}
+
+void CanvasRenderer::paint(Graphics& g)
+{
+    auto const clipBounds = g.getClipBounds();
+    auto const scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    auto const style = getStyle();
+    auto const styleHash = style.getHash();
+
+    // Tiles are only valid for one zoom level and theme
+    if (scale != tileScale || styleHash != tileStyle) {
+        clearTiles();
+        tileScale = scale;
+        tileStyle = styleHash;
+    }
+
+    auto const visibleObjects = cnv->objectIndex.query(clipBounds);
+
+    // Opening the text editor doesn't go through update(), but it makes the object draw itself
+    for (auto* object : visibleObjects) {
+        if (auto it = recordIndices.find(object); it != recordIndices.end() && records[it->second].isCandidate != isCandidate(records[it->second]))
+            occlusionDirty = true;
+    }
+
+    if (occlusionDirty)
+        updateOcclusion();
+
+    // Selection, editing and iolet visibility don't go through update(), so check the visible records against what's in the tiles
+    for (auto* object : visibleObjects) {
+        auto it = recordIndices.find(object);
+        if (it == recordIndices.end())
+            continue;
+
+        auto& record = records[it->second];
+        auto const state = getState(record);
+
+        if (state != record.state) {
+            invalidate(getDirtyArea(record));
+            record.state = state;
+        }
+    }
+
+    if (!canUseTiles(scale)) {
+        for (auto index : getRecordsInArea(clipBounds)) {
+            paintRecord(g, records[index], style);
+        }
+        return;
+    }
+
+    frameCounter++;
+
+    for (int tileX = toTile(clipBounds.getX(), tileSize); tileX <= toTile(clipBounds.getRight() - 1, tileSize); tileX++) {
+        for (int tileY = toTile(clipBounds.getY(), tileSize); tileY <= toTile(clipBounds.getBottom() - 1, tileSize); tileY++) {
+            auto const tileBounds = Rectangle<int>(tileX * tileSize, tileY * tileSize, tileSize, tileSize);
+            auto const key = getTileKey(tileX, tileY);
+
+            auto it = tiles.find(key);
+            if (it == tiles.end()) {
+                it = tiles.emplace(key, Tile { renderTile(tileBounds, style), 0 }).first;
+                tileBytes += getImageBytes(it->second.image);
+            }
+
+            it->second.lastUsed = frameCounter;
+
+            if (it->second.image.isValid())
+                g.drawImage(it->second.image, tileBounds.toFloat());
+        }
+    }
+
+    removeUnusedTiles();
+}
+
+void CanvasRenderer::paintRecord(Graphics& g, ObjectRecord const& record, Style const& style) const
+{
+    if (!record.object->isVisible() || !isBatched(record.object))
+        return;
+
+    // Same as TextBase::paint and TextBase::paintOverChildren
+    auto const box = record.bounds.toFloat();
+
+    g.setColour(style.background);
+    g.fillRoundedRectangle(box.reduced(0.5f), style.cornerRadius);
+
+    if (style.ioletArea != style.background) {
+        g.setColour(style.ioletArea);
+        g.fillRect(record.bounds.withHeight(3));
+        g.fillRect(record.bounds.withTop(record.bounds.getBottom() - 3));
+    }
+
+    g.setColour(style.text);
+    record.glyphs.draw(g, AffineTransform::translation(box.getPosition()));
+
+    bool selected = cnv->isSelected(record.object) && !cnv->isGraph;
+    auto outlineColour = selected ? style.selectedOutline : style.outline;
+
+    if (!record.isValid) {
+        outlineColour = selected ? Colours::red.brighter(1.5) : Colours::red;
+    }
+
+    g.setColour(outlineColour);
+    g.drawRoundedRectangle(box.reduced(0.5f), style.cornerRadius, 1.0f);
+
+    if (record.iolets.empty())
+        return;
+
+    // Resting state of Iolet::paint, the iolet components only draw themselves while they're being interacted with
+    g.saveState();
+    g.reduceClipRegion(record.bounds);
+
+    for (auto const& [iolet, ioletBounds] : record.iolets) {
+        if (!iolet->isVisible())
+            continue;
+
+        auto bounds = ioletBounds.reduced(0.5f).reduced(2);
+
+        if ((static_cast<int>(ioletBounds.getHeight()) % 2) == 0) {
+            bounds.translate(0.0f, iolet->isInlet ? -1.0f : 0.0f);
+        }
+
+        g.setColour(style.isLocked ? style.lockedIolet : (iolet->isSignal ? style.signal : style.data));
+
+        if (style.squareIolets) {
+            g.fillRect(bounds);
+            g.setColour(style.outline);
+            g.drawRect(bounds, 1.0f);
+        } else {
+            g.fillEllipse(bounds);
+            g.setColour(style.ioletOutline);
+            g.drawEllipse(bounds, 1.0f);
+        }
+    }
+
+    g.restoreState();
+}
@@ -0,0 +1,115 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+#include <unordered_map>
+#include <vector>
+
+class Canvas;
+class Object;
+class ObjectBase;
+class Iolet;
+
+// Optional retained-mode renderer, enabled with the "batched_rendering" setting
+// Plain text objects and their iolets are drawn from a flat array of draw records in a single paint, with the text layout cached
+// Objects stay components for interaction, but those components skip painting while the renderer draws them
+// Objects that are being edited, and all other GUI objects, keep drawing themselves
+// The renderer sits behind all objects, so objects that are stacked on top of one that draws itself have to draw themselves as well
+// The records are rasterised into tiles at the current pixel scale, so scrolling only composites images
+// A change to an object only invalidates the tiles it touches, a change of zoom level starts a new set of tiles
+// At scales where tiles wouldn't line up with device pixels, and while objects are being dragged, the records are drawn directly
+class CanvasRenderer : public Component {
+
+public:
+    explicit CanvasRenderer(Canvas* parent);
+
+    bool isEnabled() const { return enabled; }
+
+    // Call whenever the bounds, text or iolets of an object change, only repaints the area that changed
+    void update(Object* object);
+    void remove(Object* object);
+
+    // True if the renderer is currently drawing this object's body and iolets
+    bool isBatched(Object const* object) const;
+
+    // Call when the stacking order of the objects changed
+    void invalidateOcclusion() { occlusionDirty = true; }
+
+    void paint(Graphics& g) override;
+
+private:
+    struct IoletRecord {
+        Iolet* iolet; // Visibility and type are read from the iolet while painting, these can change without the object resizing
+        Rectangle<float> bounds;
+    };
+
+    struct ObjectRecord {
+        Object* object;
+        ObjectBase* gui;
+        Rectangle<int> bounds; // Box bounds in canvas coordinates, without the object margin
+        String text;
+        int numLines;
+        bool isValid;
+        GlyphArrangement glyphs; // Relative to the box
+        std::vector<IoletRecord> iolets; // In canvas coordinates
+        uint64 state = 0; // Everything else the drawing depends on, as it was when the record was last drawn into the tiles
+        int zOrder = 0;
+        bool isCandidate = false; // The object could be batched, as it was when the occlusion was last updated
+        bool isOccluded = false;  // The object overlaps something below it that draws itself
+    };
+
+    // Colours and look and feel settings that apply to all records
+    struct Style {
+        Colour background, ioletArea, text, outline, selectedOutline, ioletOutline, signal, data, lockedIolet;
+        float cornerRadius;
+        bool squareIolets;
+        bool isLocked;
+
+        uint64 getHash() const;
+    };
+
+    struct Tile {
+        Image image;
+        uint32 lastUsed;
+    };
+
+    static constexpr int tileSize = 256;
+    static constexpr size_t maxTileBytes = 64 * 1024 * 1024;
+
+    Rectangle<int> getDirtyArea(ObjectRecord const& record) const;
+    bool isCandidate(ObjectRecord const& record) const;
+    void updateOcclusion();
+    uint64 getState(ObjectRecord const& record) const;
+    Style getStyle() const;
+
+    void invalidate(Rectangle<int> area);
+    void clearTiles();
+    bool canUseTiles(float scale) const;
+
+    // Indices of the records that intersect the area, in z-order
+    std::vector<size_t> getRecordsInArea(Rectangle<int> area) const;
+
+    Image renderTile(Rectangle<int> tileBounds, Style const& style) const;
+    void paintRecord(Graphics& g, ObjectRecord const& record, Style const& style) const;
+    void removeUnusedTiles();
+
+    Canvas* cnv;
+    bool const enabled;
+
+    std::vector<ObjectRecord> records;
+    std::unordered_map<Object const*, size_t> recordIndices;
+    bool occlusionDirty = true;
+
+    std::unordered_map<int64, Tile> tiles;
+    size_t tileBytes = 0;
+    float tileScale = 0.0f;
+    uint64 tileStyle = 0;
+    uint32 frameCounter = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(CanvasRenderer)
+};
@@ -83,6 +83,7 @@ Connection::Connection(Canvas* parent, Iolet* s, Iolet* e, void* oc)
 Connection::~Connection()
 {
     cnv->pd->unregisterMessageListener(ptr, this);
+    cnv->connectionIndex.remove(this);
 
     if (outlet) {
         outlet->repaint();
@@ -237,13 +238,11 @@ bool Connection::intersects(Rectangle<float> toCheck, int accuracy) const
     return false;
 }
 
-void Connection::renderConnectionPath(Graphics& g, Canvas* cnv, Path connectionPath, bool isSignal, bool isMouseOver, bool isSelected, Point<int> mousePos, bool isHovering)
+Colour Connection::getConnectionColour(Canvas* cnv, bool isSignal, bool isMouseOver, bool isSelected)
 {
-
     auto baseColour = cnv->findColour(PlugDataColour::connectionColourId);
     auto dataColour = cnv->findColour(PlugDataColour::dataColourId);
     auto signalColour = cnv->findColour(PlugDataColour::signalColourId);
-    auto handleColour = isSignal ? dataColour : signalColour;
 
     if (isSelected) {
         baseColour = isSignal ? signalColour : dataColour;
@@ -252,16 +251,22 @@ void Connection::renderConnectionPath(Graphics& g, Canvas* cnv, Path connectionP
         baseColour = baseColour.brighter(0.6f);
     }
 
+    return baseColour;
+}
+
+void Connection::createStrokes(Path const& connectionPath, bool isSignal, Path& outerStroke, Path& innerStroke)
+{
     bool useThinConnection = PlugDataLook::getUseThinConnections();
 
+    // Stroke with extra accuracy, so the outline still looks smooth at the maximum zoom level
+    float const accuracy = 2.0f;
+
     // outer stroke
-    g.setColour(baseColour.darker(1.0f));
-    g.strokePath(connectionPath, PathStrokeType(useThinConnection ? 1.0f : 2.5f, PathStrokeType::mitered, PathStrokeType::rounded));
+    PathStrokeType(useThinConnection ? 1.0f : 2.5f, PathStrokeType::mitered, PathStrokeType::rounded).createStrokedPath(outerStroke, connectionPath, {}, accuracy);
 
     // inner stroke
-    g.setColour(baseColour);
     Path innerPath = connectionPath;
-    PathStrokeType innerStroke(useThinConnection ? 1.0f : 1.5f);
+    PathStrokeType innerStrokeType(useThinConnection ? 1.0f : 1.5f);
 
     if (PlugDataLook::getUseDashedConnections() && isSignal) {
         PathStrokeType dashedStroke(useThinConnection ? 0.5f : 0.8f);
@@ -269,33 +274,71 @@ void Connection::renderConnectionPath(Graphics& g, Canvas* cnv, Path connectionP
         Path dashedPath;
         dashedStroke.createDashedStroke(dashedPath, connectionPath, dash, 1);
         innerPath = dashedPath;
-        innerStroke = dashedStroke;
+        innerStrokeType = dashedStroke;
     }
-    innerStroke.setEndStyle(PathStrokeType::EndCapStyle::rounded);
-    g.strokePath(innerPath, innerStroke);
+    innerStrokeType.setEndStyle(PathStrokeType::EndCapStyle::rounded);
+    innerStrokeType.createStrokedPath(innerStroke, innerPath, {}, accuracy);
+}
+
+void Connection::drawReconnectHandles(Graphics& g, Canvas* cnv, bool isSignal, Rectangle<float> startHandle, Rectangle<float> endHandle, Point<float> mousePos)
+{
+    bool overStart = startHandle.contains(mousePos);
+    bool overEnd = endHandle.contains(mousePos);
+
+    g.setColour(cnv->findColour(isSignal ? PlugDataColour::dataColourId : PlugDataColour::signalColourId));
+
+    g.fillEllipse(startHandle.expanded(overStart ? 3.0f : 0.0f));
+    g.fillEllipse(endHandle.expanded(overEnd ? 3.0f : 0.0f));
+
+    g.setColour(cnv->findColour(PlugDataColour::objectOutlineColourId));
+    g.drawEllipse(startHandle.expanded(overStart ? 3.0f : 0.0f), 0.5f);
+    g.drawEllipse(endHandle.expanded(overEnd ? 3.0f : 0.0f), 0.5f);
+}
+
+void Connection::renderConnectionPath(Graphics& g, Canvas* cnv, Path connectionPath, bool isSignal, bool isMouseOver, bool isSelected, Point<int> mousePos, bool isHovering)
+{
+    auto baseColour = getConnectionColour(cnv, isSignal, isMouseOver, isSelected);
+
+    Path outerStroke, innerStroke;
+    createStrokes(connectionPath, isSignal, outerStroke, innerStroke);
+
+    g.setColour(baseColour.darker(1.0f));
+    g.fillPath(outerStroke);
+
+    g.setColour(baseColour);
+    g.fillPath(innerStroke);
 
     // draw reconnect handles if connection is both selected & mouse is hovering over
     if (isSelected && isHovering) {
         auto startReconnectHandle = Rectangle<float>(5, 5).withCentre(connectionPath.getPointAlongPath(8.5f));
         auto endReconnectHandle = Rectangle<float>(5, 5).withCentre(connectionPath.getPointAlongPath(std::max(connectionPath.getLength() - 8.5f, 9.5f)));
 
-        bool overStart = startReconnectHandle.contains(mousePos.toFloat());
-        bool overEnd = endReconnectHandle.contains(mousePos.toFloat());
-
-        g.setColour(handleColour);
-
-        g.fillEllipse(startReconnectHandle.expanded(overStart ? 3.0f : 0.0f));
-        g.fillEllipse(endReconnectHandle.expanded(overEnd ? 3.0f : 0.0f));
-
-        g.setColour(cnv->findColour(PlugDataColour::objectOutlineColourId));
-        g.drawEllipse(startReconnectHandle.expanded(overStart ? 3.0f : 0.0f), 0.5f);
-        g.drawEllipse(endReconnectHandle.expanded(overEnd ? 3.0f : 0.0f), 0.5f);
+        drawReconnectHandles(g, cnv, isSignal, startReconnectHandle, endReconnectHandle, mousePos.toFloat());
     }
 }
 
-void Connection::paint(Graphics& g)
+void Connection::paintCached(Graphics& g)
 {
-    renderConnectionPath(g, cnv, toDraw, outlet->isSignal, isMouseOver(), cnv->isSelected(this), getMouseXYRelative(), isHovering);
+    if (!outlet || !hasGeometry)
+        return;
+
+    // The dashed style depends on the outlet type, which can change without the path changing
+    if (outlet->isSignal != strokesAreSignal)
+        updateStrokes();
+
+    auto isSelected = cnv->isSelected(this);
+    auto baseColour = getConnectionColour(cnv, strokesAreSignal, isMouseOver(), isSelected);
+
+    g.setColour(baseColour.darker(1.0f));
+    g.fillPath(outerStroke);
+
+    g.setColour(baseColour);
+    g.fillPath(innerStroke);
+
+    if (isSelected && isHovering) {
+        auto const position = getPosition().toFloat();
+        drawReconnectHandles(g, cnv, strokesAreSignal, startReconnectHandle + position, endReconnectHandle + position, getMouseXYRelative().toFloat() + position);
+    }
 }
 
 bool Connection::isSegmented()
@@ -387,6 +430,9 @@ void Connection::mouseDrag(MouseEvent const& e)
         return;
 
     if (isSegmented() && dragIdx != -1) {
+        routeGeneration++;
+        routePending = false;
+
         auto n = dragIdx;
         auto delta = e.getPosition() - e.getMouseDownPosition();
         auto line = Line<float>(currentPlan[n - 1], currentPlan[n]);
@@ -493,16 +539,28 @@ void Connection::componentMovedOrResized(Component& component, bool wasMoved, bo
     auto pstart = getStartPoint();
     auto pend = getEndPoint();
 
-    if (currentPlan.size() <= 2) {
-        updatePath();
-        return;
+    if (hasGeometry) {
+        // Nothing to do if neither end actually moved
+        if (pstart == lastStart && pend == lastEnd)
+            return;
+
+        // Both ends moved by the same amount, like when dragging a selection: move the cached geometry instead of rebuilding it
+        auto const offset = pstart - lastStart;
+        if (pend - lastEnd == offset && offset.roundToInt().toFloat() == offset) {
+            cancelPendingUpdate();
+            translate(offset);
+            return;
+        }
     }
 
-    // If both inlet and outlet are selected we can just move the connection cord
+    // If both inlet and outlet are selected, the other end will move right after this one
+    // Wait for that, instead of rebuilding the path for every object in the selection
     if ((cnv->isSelected(outobj) && cnv->isSelected(inobj)) || cnv->updatingBounds) {
-        auto offset = pstart - currentPlan[0];
-        for (auto& point : currentPlan)
-            point += offset;
+        triggerAsyncUpdate();
+        return;
+    }
+
+    if (currentPlan.size() <= 2) {
         updatePath();
         return;
     }
@@ -566,6 +624,49 @@ Path Connection::getNonSegmentedPath(Point<float> start, Point<float> end)
     return connectionPath;
 }
 
+void Connection::handleAsyncUpdate()
+{
+    if (!inlet || !outlet)
+        return;
+
+    // The ends didn't end up moving together, so we can just move the connection cord
+    if (currentPlan.size() > 2) {
+        auto offset = getStartPoint() - currentPlan[0];
+        for (auto& point : currentPlan)
+            point += offset;
+    }
+
+    updatePath();
+}
+
+void Connection::translate(Point<float> offset)
+{
+    for (auto& point : currentPlan)
+        point += offset;
+
+    origin += offset;
+    lastStart += offset;
+    lastEnd += offset;
+
+    auto const transform = AffineTransform::translation(offset);
+    outerStroke.applyTransform(transform);
+    innerStroke.applyTransform(transform);
+
+    setTopLeftPosition(getPosition() + offset.roundToInt());
+    cnv->connectionIndex.update(this, getBounds());
+}
+
+void Connection::updateStrokes()
+{
+    strokesAreSignal = outlet && outlet->isSignal;
+    createStrokes(toDraw, strokesAreSignal, outerStroke, innerStroke);
+
+    // Strokes are kept in canvas coordinates, so the canvas can draw all connections in one go
+    auto const transform = AffineTransform::translation(getPosition().toFloat());
+    outerStroke.applyTransform(transform);
+    innerStroke.applyTransform(transform);
+}
+
 void Connection::updatePath()
 {
     if (!outlet || !inlet)
@@ -585,8 +686,11 @@ void Connection::updatePath()
         toDraw = getNonSegmentedPath(pstart, pend);
         currentPlan.clear();
     } else {
+        // Draw the default path until the router has found a better one
         if (currentPlan.empty()) {
-            findPath();
+            currentPlan = ConnectionRouter::getDefaultPath(getStartPoint(), getEndPoint());
+            if (!routePending)
+                findPath();
         }
 
         auto snap = [this](Point<float> point, int idx1, int idx2) {
@@ -621,6 +725,7 @@ void Connection::updatePath()
 
     auto bounds = toDraw.getBounds().expanded(8);
     setBounds((bounds + origin).getSmallestIntegerContainer());
+    cnv->connectionIndex.update(this, getBounds());
 
     if (bounds.getX() < 0 || bounds.getY() < 0) {
         toDraw.applyTransform(AffineTransform::translation(-bounds.getX() + 0.5f, -bounds.getY()));
@@ -630,6 +735,12 @@ void Connection::updatePath()
 
     startReconnectHandle = Rectangle<float>(5, 5).withCentre(toDraw.getPointAlongPath(8.5f));
     endReconnectHandle = Rectangle<float>(5, 5).withCentre(toDraw.getPointAlongPath(std::max(toDraw.getLength() - 8.5f, 9.5f)));
+
+    lastStart = getStartPoint();
+    lastEnd = getEndPoint();
+    hasGeometry = true;
+
+    updateStrokes();
 }
 
 void Connection::findPath()
@@ -637,175 +748,7 @@ void Connection::findPath()
     if (!outlet || !inlet)
         return;
 
-    auto pstart = getStartPoint();
-    auto pend = getEndPoint();
-
-    auto pathStack = PathPlan();
-    auto bestPath = PathPlan();
-
-    pathStack.reserve(8);
-
-    auto numFound = 0;
-
-    float incrementX, incrementY;
-
-    auto distance = pstart.getDistanceFrom(pend);
-    auto distanceX = std::abs(pstart.x - pend.x);
-    auto distanceY = std::abs(pstart.y - pend.y);
-
-    int maxXResolution = std::clamp<int>(distanceX / 10, 6, 14);
-    int maxYResolution = std::clamp<int>(distanceY / 10, 6, 14);
-
-    int resolutionX = 6;
-    int resolutionY = 6;
-
-    auto obstacles = Array<Rectangle<float>>();
-    auto searchBounds = Rectangle<float>(pstart, pend);
-
-    for (auto* object : cnv->objects) {
-        if (object->getBounds().toFloat().intersects(searchBounds)) {
-            obstacles.add(object->getBounds().toFloat());
-        }
-    }
-
-    // Look for paths at an increasing resolution
-    while (!numFound && resolutionX < maxXResolution && distance > 40) {
-
-        // Find paths on a resolution*resolution lattice ObjectGrid
-        incrementX = std::max<float>(1, distanceX / resolutionX);
-        incrementY = std::max<float>(1, distanceY / resolutionY);
-
-        numFound = findLatticePaths(bestPath, pathStack, pend, pstart, { incrementX, incrementY });
-
-        if (resolutionX < maxXResolution)
-            resolutionX++;
-        if (resolutionY < maxXResolution)
-            resolutionY++;
-
-        if (resolutionX > maxXResolution || resolutionY > maxYResolution)
-            break;
-
-        pathStack.clear();
-    }
-
-    PathPlan simplifiedPath;
-
-    bool direction;
-    if (!bestPath.empty()) {
-        simplifiedPath.push_back(bestPath.front());
-
-        direction = bestPath[0].x == bestPath[1].x;
-
-        if (!direction)
-            simplifiedPath.push_back(bestPath.front());
-
-        for (int n = 1; n < bestPath.size(); n++) {
-            if ((bestPath[n].x != bestPath[n - 1].x && direction) || (bestPath[n].y != bestPath[n - 1].y && !direction)) {
-                simplifiedPath.push_back(bestPath[n - 1]);
-                direction = !direction;
-            }
-        }
-
-        simplifiedPath.push_back(bestPath.back());
-
-        if (!direction)
-            simplifiedPath.push_back(bestPath.back());
-    } else {
-        if (pend.y < pstart.y) {
-            int xHalfDistance = (pstart.x - pend.x) / 2;
-
-            simplifiedPath.push_back(pend); // double to make it draggable
-            simplifiedPath.push_back(pend);
-            simplifiedPath.push_back({ pend.x + xHalfDistance, pend.y });
-            simplifiedPath.push_back({ pend.x + xHalfDistance, pstart.y });
-            simplifiedPath.push_back(pstart);
-            simplifiedPath.push_back(pstart);
-        } else {
-            int yHalfDistance = (pstart.y - pend.y) / 2;
-            simplifiedPath.push_back(pend);
-            simplifiedPath.push_back({ pend.x, pend.y + yHalfDistance });
-            simplifiedPath.push_back({ pstart.x, pend.y + yHalfDistance });
-            simplifiedPath.push_back(pstart);
-        }
-    }
-    std::reverse(simplifiedPath.begin(), simplifiedPath.end());
-
-    currentPlan = simplifiedPath;
-
-    pushPathState();
-}
-
-int Connection::findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> pstart, Point<float> pend, Point<float> increment)
-{
-
-    auto obstacles = Array<Object*>();
-    auto searchBounds = Rectangle<float>(pstart, pend);
-
-    for (auto* object : cnv->objects) {
-        if (object->getBounds().toFloat().intersects(searchBounds)) {
-            obstacles.add(object);
-        }
-    }
-
-    // Stop after we've found a path
-    if (!bestPath.empty())
-        return 0;
-
-    // Add point to path
-    pathStack.push_back(pstart);
-
-    // Check if it intersects any object
-    if (pathStack.size() > 1 && straightLineIntersectsObject(Line<float>(pathStack.back(), *(pathStack.end() - 2)), obstacles)) {
-        return 0;
-    }
-
-    bool endVertically = pathStack[0].y > pend.y;
-
-    // Check if we've reached the destination
-    if (std::abs(pstart.x - pend.x) < (increment.x * 0.5) && std::abs(pstart.y - pend.y) < (increment.y * 0.5)) {
-        bestPath = pathStack;
-        return 1;
-    }
-
-    // Count the number of found paths
-    int count = 0;
-
-    // Get current stack to revert to after each trial
-    auto pathCopy = pathStack;
-
-    auto followLine = [this, &count, &pathCopy, &bestPath, &pathStack, &increment](Point<float> currentOutlet, Point<float> currentInlet, bool isX) {
-        auto& coord1 = isX ? currentOutlet.x : currentOutlet.y;
-        auto& coord2 = isX ? currentInlet.x : currentInlet.y;
-        auto& incr = isX ? increment.x : increment.y;
-
-        if (std::abs(coord1 - coord2) >= incr) {
-            coord1 > coord2 ? coord1 -= incr : coord1 += incr;
-            count += findLatticePaths(bestPath, pathStack, currentOutlet, currentInlet, increment);
-            pathStack = pathCopy;
-        }
-    };
-
-    // If we're halfway on the axis, change preferred direction by inverting search order
-    // This will make it do a staircase effect
-    if (endVertically) {
-        if (std::abs(pstart.y - pend.y) >= std::abs(pathStack[0].y - pend.y) * 0.5) {
-            followLine(pstart, pend, false);
-            followLine(pstart, pend, true);
-        } else {
-            followLine(pstart, pend, true);
-            followLine(pstart, pend, false);
-        }
-    } else {
-        if (std::abs(pstart.x - pend.x) >= std::abs(pathStack[0].x - pend.x) * 0.5) {
-            followLine(pstart, pend, true);
-            followLine(pstart, pend, false);
-        } else {
-            followLine(pstart, pend, false);
-            followLine(pstart, pend, true);
-        }
-    }
-
-    return count;
+    cnv->router->route({ this });
 }
 
 bool Connection::intersectsObject(Object* object)
@@ -817,45 +760,20 @@ bool Connection::intersectsObject(Object* object)
         || toDraw.intersectsLine({ b.getBottomRight(), b.getTopRight() });
 }
 
-bool Connection::straightLineIntersectsObject(Line<float> toCheck, Array<Object*>& objects)
+ConnectionLayer::ConnectionLayer(Canvas* canvas)
+    : cnv(canvas)
 {
+    setInterceptsMouseClicks(false, false);
+}
 
-    for (auto const& object : objects) {
-        auto bounds = object->getBounds().expanded(1);
-
-        if (object == outobj || object == inobj || !bounds.intersects(getBounds()))
-            continue;
-
-        auto intersectV = [](Line<float> first, Line<float> second) {
-            if (first.getStartY() > first.getEndY()) {
-                first = { first.getEnd(), first.getStart() };
-            }
-
-            return first.getStartX() > second.getStartX() && first.getStartX() < second.getEndX() && second.getStartY() > first.getStartY() && second.getStartY() < first.getEndY();
-        };
-
-        auto intersectH = [](Line<float> first, Line<float> second) {
-            if (first.getStartX() > first.getEndX()) {
-                first = { first.getEnd(), first.getStart() };
-            }
-
-            return first.getStartY() > second.getStartY() && first.getStartY() < second.getEndY() && second.getStartX() > first.getStartX() && second.getStartX() < first.getEndX();
-        };
-
-        bool intersectsV = toCheck.isVertical() && (intersectV(toCheck, Line<float>(bounds.getTopLeft().toFloat(), bounds.getTopRight().toFloat())) || intersectV(toCheck, Line<float>(bounds.getBottomRight().toFloat(), bounds.getBottomLeft().toFloat())));
-
-        bool intersectsH = toCheck.isHorizontal() && (intersectH(toCheck, Line<float>(bounds.getTopRight().toFloat(), bounds.getBottomRight().toFloat())) || intersectH(toCheck, Line<float>(bounds.getTopLeft().toFloat(), bounds.getBottomLeft().toFloat())));
-        if (intersectsV || intersectsH) {
-            return true;
-        }
+void ConnectionLayer::paint(Graphics& g)
+{
+    auto const clipBounds = g.getClipBounds();
 
-        /*
-         if(bounds.toFloat().intersects(toCheck.toFloat())) {
-         return true;
-         } TODO: benchmark these two options */
-        // TODO: possible mark areas that have already been visited?
+    for (auto* connection : cnv->connections) {
+        if (connection->isVisible() && connection->getBounds().intersects(clipBounds))
+            connection->paintCached(g);
     }
-    return false;
 }
 
 void ConnectionPathUpdater::timerCallback()
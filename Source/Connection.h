@@ -14,11 +14,10 @@ extern "C" {
 
 #include <concurrentqueue.h>
 #include "Iolet.h"
+#include "ConnectionRouter.h"
 #include "Pd/PdInstance.h"
 #include "Utility/RateReducer.h"
 
-using PathPlan = std::vector<Point<float>>;
-
 class Canvas;
 class PathUpdater;
 
@@ -26,7 +25,8 @@ class Connection : public Component
     , public ComponentListener
     , public Value::Listener
     , public pd::MessageListener
-    , public SettableTooltipClient {
+    , public SettableTooltipClient
+    , public AsyncUpdater {
 public:
     int inIdx;
     int outIdx;
@@ -44,7 +44,8 @@ public:
 
     static Path getNonSegmentedPath(Point<float> start, Point<float> end);
 
-    void paint(Graphics&) override;
+    // Connections don't paint themselves, the ConnectionLayer draws all of them from their cached strokes
+    void paintCached(Graphics& g);
 
     bool isSegmented();
     void setSegmented(bool segmented);
@@ -80,14 +81,12 @@ public:
     void popPathState();
 
     void componentMovedOrResized(Component& component, bool wasMoved, bool wasResized) override;
+    void handleAsyncUpdate() override;
 
-    // Pathfinding
-    int findLatticePaths(PathPlan& bestPath, PathPlan& pathStack, Point<float> start, Point<float> end, Point<float> increment);
-
+    // Pathfinding, the route gets applied asynchronously
     void findPath();
 
     bool intersectsObject(Object* object);
-    bool straightLineIntersectsObject(Line<float> toCheck, Array<Object*>& objects);
 
     void receiveMessage(String const& name, int argc, t_atom* argv) override;
 
@@ -101,6 +100,20 @@ private:
 
     PathPlan currentPlan;
 
+    // Pre-stroked geometry in canvas coordinates, only rebuilt when the path changes shape
+    Path outerStroke, innerStroke;
+    bool strokesAreSignal = false;
+
+    // Start and end point the current geometry was built for
+    Point<float> lastStart, lastEnd;
+    bool hasGeometry = false;
+
+    // Incremented whenever a route is requested or the user edits the path, so we can drop outdated routes
+    int routeGeneration = 0;
+
+    // Set while the router is working on a route for us, so updatePath doesn't request another one
+    bool routePending = false;
+
     Value locked;
     Value presentationMode;
 
@@ -115,6 +128,13 @@ private:
 
     void valueChanged(Value& v) override;
 
+    void translate(Point<float> offset);
+    void updateStrokes();
+
+    static Colour getConnectionColour(Canvas* cnv, bool isSignal, bool isMouseOver, bool isSelected);
+    static void createStrokes(Path const& connectionPath, bool isSignal, Path& outerStroke, Path& innerStroke);
+    static void drawReconnectHandles(Graphics& g, Canvas* cnv, bool isSignal, Rectangle<float> startHandle, Rectangle<float> endHandle, Point<float> mousePos);
+
     struct t_fake_outconnect {
         void* oc_next;
         t_pd* oc_to;
@@ -124,6 +144,7 @@ private:
     t_fake_outconnect* ptr;
 
     friend class ConnectionPathUpdater;
+    friend class ConnectionRouter;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Connection)
 };
 
@@ -201,6 +222,17 @@ public:
     RateReducer rateReducer = RateReducer(90);
 };
 
+// Draws all connections of a canvas in a single pass, using the strokes that each connection caches
+// The connection components themselves are still used for mouse interaction
+class ConnectionLayer : public Component {
+    Canvas* cnv;
+
+public:
+    explicit ConnectionLayer(Canvas* canvas);
+
+    void paint(Graphics& g) override;
+};
+
 // Helper class to group connection path changes together into undoable/redoable actions
 class ConnectionPathUpdater : public Timer {
     Canvas* canvas;
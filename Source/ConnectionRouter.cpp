@@ -0,0 +1,340 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "ConnectionRouter.h"
+#include "Canvas.h"
+#include "Connection.h"
+#include "Object.h"
+
+#include <queue>
+
+static int64 getTileKey(int x, int y)
+{
+    return (static_cast<int64>(x) << 32) | static_cast<uint32>(y);
+}
+
+static int toTile(int cell, int tileSize)
+{
+    return cell >= 0 ? cell / tileSize : (cell - tileSize + 1) / tileSize;
+}
+
+void ObstacleMap::update(Object* object, Rectangle<int> bounds)
+{
+    auto it = objectBounds.find(object);
+    if (it != objectBounds.end()) {
+        if (it->second == bounds)
+            return;
+
+        addToCells(it->second, -1);
+        it->second = bounds;
+    } else {
+        objectBounds.emplace(object, bounds);
+    }
+
+    addToCells(bounds, 1);
+}
+
+void ObstacleMap::remove(Object* object)
+{
+    auto it = objectBounds.find(object);
+    if (it == objectBounds.end())
+        return;
+
+    addToCells(it->second, -1);
+    objectBounds.erase(it);
+}
+
+void ObstacleMap::addToCells(Rectangle<int> bounds, int delta)
+{
+    if (bounds.isEmpty())
+        return;
+
+    auto const cellArea = toCellArea(bounds);
+
+    for (int tileX = toTile(cellArea.getX(), tileSize); tileX <= toTile(cellArea.getRight() - 1, tileSize); tileX++) {
+        for (int tileY = toTile(cellArea.getY(), tileSize); tileY <= toTile(cellArea.getBottom() - 1, tileSize); tileY++) {
+            auto& tile = tiles[getTileKey(tileX, tileY)];
+            if (!tile)
+                tile = std::make_unique<Tile>();
+
+            auto const tileArea = Rectangle<int>(tileX * tileSize, tileY * tileSize, tileSize, tileSize);
+            auto const area = tileArea.getIntersection(cellArea);
+
+            for (int y = area.getY(); y < area.getBottom(); y++) {
+                auto* row = tile->counts + (y - tileArea.getY()) * tileSize - tileArea.getX();
+                for (int x = area.getX(); x < area.getRight(); x++) {
+                    row[x] = static_cast<uint16>(row[x] + delta);
+                }
+            }
+
+            tile->total += static_cast<int64>(delta) * area.getWidth() * area.getHeight();
+
+            if (tile->total == 0)
+                tiles.erase(getTileKey(tileX, tileY));
+        }
+    }
+}
+
+std::vector<uint8> ObstacleMap::getBlockedCells(Rectangle<int> cellArea) const
+{
+    auto blocked = std::vector<uint8>(static_cast<size_t>(cellArea.getWidth()) * cellArea.getHeight(), 0);
+
+    if (cellArea.isEmpty())
+        return blocked;
+
+    for (int tileX = toTile(cellArea.getX(), tileSize); tileX <= toTile(cellArea.getRight() - 1, tileSize); tileX++) {
+        for (int tileY = toTile(cellArea.getY(), tileSize); tileY <= toTile(cellArea.getBottom() - 1, tileSize); tileY++) {
+            auto it = tiles.find(getTileKey(tileX, tileY));
+            if (it == tiles.end())
+                continue;
+
+            auto const tileArea = Rectangle<int>(tileX * tileSize, tileY * tileSize, tileSize, tileSize);
+            auto const area = tileArea.getIntersection(cellArea);
+
+            for (int y = area.getY(); y < area.getBottom(); y++) {
+                auto const* row = it->second->counts + (y - tileArea.getY()) * tileSize - tileArea.getX();
+                auto* target = blocked.data() + static_cast<size_t>(y - cellArea.getY()) * cellArea.getWidth() - cellArea.getX();
+                for (int x = area.getX(); x < area.getRight(); x++) {
+                    target[x] = row[x] != 0;
+                }
+            }
+        }
+    }
+
+    return blocked;
+}
+
+ConnectionRouter::ConnectionRouter(Canvas* parent)
+    : cnv(parent)
+{
+}
+
+void ConnectionRouter::route(Array<Connection*> const& connections)
+{
+    std::vector<Request> requests;
+    requests.reserve(connections.size());
+
+    for (auto* connection : connections) {
+        if (!connection->inlet || !connection->outlet)
+            continue;
+
+        auto const start = connection->getStartPoint();
+        auto const end = connection->getEndPoint();
+        auto const cellArea = ObstacleMap::toCellArea(Rectangle<float>(start, end).getSmallestIntegerContainer().expanded(searchMargin));
+
+        auto& request = requests.emplace_back();
+        request.connection = connection;
+        request.generation = ++connection->routeGeneration;
+        connection->routePending = true;
+        request.start = start;
+        request.end = end;
+        request.cellArea = cellArea;
+
+        if (cellArea.getWidth() * cellArea.getHeight() > maxCells)
+            continue;
+
+        request.blocked = cnv->obstacleMap.getBlockedCells(cellArea);
+
+        // The objects we connect to are never obstacles
+        for (auto* object : { connection->outobj.getComponent(), connection->inobj.getComponent() }) {
+            if (!object)
+                continue;
+
+            auto const area = ObstacleMap::toCellArea(object->getBounds()).getIntersection(cellArea);
+            for (int y = area.getY(); y < area.getBottom(); y++) {
+                auto* row = request.blocked.data() + static_cast<size_t>(y - cellArea.getY()) * cellArea.getWidth() - cellArea.getX();
+                std::fill(row + area.getX(), row + area.getRight(), 0);
+            }
+        }
+    }
+
+    if (requests.empty())
+        return;
+
+    pool->addJob([requests = std::move(requests)]() {
+        std::vector<std::tuple<Component::SafePointer<Connection>, int, PathPlan>> results;
+        results.reserve(requests.size());
+
+        for (auto const& request : requests) {
+            auto plan = request.blocked.empty() ? PathPlan() : findPath(request.start, request.end, request.cellArea, request.blocked);
+
+            if (plan.empty())
+                plan = getDefaultPath(request.start, request.end);
+
+            results.emplace_back(request.connection, request.generation, std::move(plan));
+        }
+
+        MessageManager::callAsync([results = std::move(results)]() {
+            for (auto const& [connection, generation, plan] : results) {
+                // Skip connections that were deleted, changed by the user, or re-routed since
+                if (!connection || connection->routeGeneration != generation)
+                    continue;
+
+                connection->routePending = false;
+                if (!connection->isSegmented())
+                    continue;
+
+                connection->currentPlan = plan;
+                connection->pushPathState();
+                connection->updatePath();
+            }
+        });
+    });
+}
+
+PathPlan ConnectionRouter::findPath(Point<float> start, Point<float> end, Rectangle<int> cellArea, std::vector<uint8> const& blocked)
+{
+    auto const width = cellArea.getWidth();
+    auto const height = cellArea.getHeight();
+
+    auto const startX = ObstacleMap::toCell(static_cast<int>(std::floor(start.x))) - cellArea.getX();
+    auto const startY = ObstacleMap::toCell(static_cast<int>(std::floor(start.y))) - cellArea.getY();
+    auto const endX = ObstacleMap::toCell(static_cast<int>(std::floor(end.x))) - cellArea.getX();
+    auto const endY = ObstacleMap::toCell(static_cast<int>(std::floor(end.y))) - cellArea.getY();
+
+    if (start.getDistanceFrom(end) <= 40 || !isPositiveAndBelow(startX, width) || !isPositiveAndBelow(startY, height) || !isPositiveAndBelow(endX, width) || !isPositiveAndBelow(endY, height))
+        return {};
+
+    auto const startCell = startY * width + startX;
+    auto const endCell = endY * width + endX;
+
+    // Every cell has two states: entered horizontally (0) or vertically (1), so we can charge for corners
+    auto const numStates = static_cast<size_t>(width) * height * 2;
+    auto costs = std::vector<int>(numStates, std::numeric_limits<int>::max());
+    auto parents = std::vector<int>(numStates, -1);
+
+    auto const heuristic = [endX, endY, width](int cell) {
+        return std::abs(cell % width - endX) + std::abs(cell / width - endY);
+    };
+
+    using Node = std::pair<int, int>; // estimated total cost, state
+    std::priority_queue<Node, std::vector<Node>, std::greater<>> open;
+
+    // Leave the outlet going down
+    auto const startState = startCell * 2 + 1;
+    costs[startState] = 0;
+    open.emplace(heuristic(startCell), startState);
+
+    auto const isBlocked = [&blocked, startCell, endCell](int cell) {
+        return blocked[cell] && cell != startCell && cell != endCell;
+    };
+
+    int endState = -1;
+
+    while (!open.empty()) {
+        auto const [estimate, state] = open.top();
+        open.pop();
+
+        auto const cell = state / 2;
+        auto const vertical = state & 1;
+        auto const cost = costs[state];
+
+        // Already expanded with a lower cost
+        if (estimate - heuristic(cell) > cost)
+            continue;
+
+        if (cell == endCell) {
+            endState = state;
+            break;
+        }
+
+        auto const x = cell % width;
+        auto const y = cell / width;
+
+        auto const expand = [&](int nextX, int nextY, int nextVertical) {
+            if (!isPositiveAndBelow(nextX, width) || !isPositiveAndBelow(nextY, height))
+                return;
+
+            auto const nextCell = nextY * width + nextX;
+            if (isBlocked(nextCell))
+                return;
+
+            auto const nextState = nextCell * 2 + nextVertical;
+            auto const nextCost = cost + 1 + (nextVertical != vertical ? bendCost : 0);
+
+            if (nextCost < costs[nextState]) {
+                costs[nextState] = nextCost;
+                parents[nextState] = state;
+                open.emplace(nextCost + heuristic(nextCell), nextState);
+            }
+        };
+
+        expand(x - 1, y, 0);
+        expand(x + 1, y, 0);
+        expand(x, y - 1, 1);
+        expand(x, y + 1, 1);
+    }
+
+    if (endState < 0)
+        return {};
+
+    PathPlan path;
+    for (auto state = endState; state >= 0; state = parents[state]) {
+        auto const cell = state / 2;
+        auto const x = (cell % width + cellArea.getX()) * ObstacleMap::cellSize + ObstacleMap::cellSize / 2;
+        auto const y = (cell / width + cellArea.getY()) * ObstacleMap::cellSize + ObstacleMap::cellSize / 2;
+        path.emplace_back(static_cast<float>(x), static_cast<float>(y));
+    }
+
+    std::reverse(path.begin(), path.end());
+
+    if (path.size() < 2)
+        return {};
+
+    return simplifyPath(path);
+}
+
+PathPlan ConnectionRouter::simplifyPath(PathPlan const& path)
+{
+    PathPlan simplifiedPath;
+
+    simplifiedPath.push_back(path.front());
+
+    bool direction = path[0].x == path[1].x;
+
+    if (!direction)
+        simplifiedPath.push_back(path.front());
+
+    for (size_t n = 1; n < path.size(); n++) {
+        if ((path[n].x != path[n - 1].x && direction) || (path[n].y != path[n - 1].y && !direction)) {
+            simplifiedPath.push_back(path[n - 1]);
+            direction = !direction;
+        }
+    }
+
+    simplifiedPath.push_back(path.back());
+
+    if (!direction)
+        simplifiedPath.push_back(path.back());
+
+    return simplifiedPath;
+}
+
+PathPlan ConnectionRouter::getDefaultPath(Point<float> start, Point<float> end)
+{
+    PathPlan path;
+
+    if (end.y < start.y) {
+        int xHalfDistance = (start.x - end.x) / 2;
+
+        path.push_back(end); // double to make it draggable
+        path.push_back(end);
+        path.push_back({ end.x + xHalfDistance, end.y });
+        path.push_back({ end.x + xHalfDistance, start.y });
+        path.push_back(start);
+        path.push_back(start);
+    } else {
+        int yHalfDistance = (start.y - end.y) / 2;
+        path.push_back(end);
+        path.push_back({ end.x, end.y + yHalfDistance });
+        path.push_back({ start.x, end.y + yHalfDistance });
+        path.push_back(start);
+    }
+
+    std::reverse(path.begin(), path.end());
+
+    return path;
+}
@@ -0,0 +1,109 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+#include <unordered_map>
+#include <vector>
+
+using PathPlan = std::vector<Point<float>>;
+
+class Object;
+class Canvas;
+class Connection;
+
+// Coarse occupancy grid of all object bounds on a canvas, used as the obstacle map for connection routing
+// Kept up to date by the objects themselves whenever they move or resize, so routing never has to look at every object
+class ObstacleMap {
+
+public:
+    static constexpr int cellSize = 8;
+
+    void update(Object* object, Rectangle<int> bounds);
+    void remove(Object* object);
+
+    // Copies the area (in cells) into a flat bitmap, 1 means blocked
+    std::vector<uint8> getBlockedCells(Rectangle<int> cellArea) const;
+
+    static int toCell(int coordinate)
+    {
+        return coordinate >= 0 ? coordinate / cellSize : (coordinate - cellSize + 1) / cellSize;
+    }
+
+    static Rectangle<int> toCellArea(Rectangle<int> bounds)
+    {
+        auto const x = toCell(bounds.getX());
+        auto const y = toCell(bounds.getY());
+        return { x, y, toCell(bounds.getRight() - 1) - x + 1, toCell(bounds.getBottom() - 1) - y + 1 };
+    }
+
+private:
+    static constexpr int tileSize = 64; // in cells
+
+    struct Tile {
+        uint16 counts[tileSize * tileSize] = {};
+        int64 total = 0;
+    };
+
+    void addToCells(Rectangle<int> bounds, int delta);
+
+    std::unordered_map<int64, std::unique_ptr<Tile>> tiles;
+    std::unordered_map<Object*, Rectangle<int>> objectBounds;
+};
+
+// Grid A* router for segmented connections
+// Obstacles for all connections are copied out of the obstacle map on the message thread, then everything is routed in one pass on a background thread
+// Results are applied on the message thread, and get stored in pd through the ConnectionPathUpdater
+class ConnectionRouter {
+
+public:
+    explicit ConnectionRouter(Canvas* parent);
+
+    void route(Array<Connection*> const& connections);
+
+    // Returns an empty plan if there is no route within the search area
+    static PathPlan findPath(Point<float> start, Point<float> end, Rectangle<int> cellArea, std::vector<uint8> const& blocked);
+
+    // Turns a path of lattice points into the format the connection stores: alternating vertical and horizontal segments,
+    // starting and ending with a vertical one. The first and last point get doubled if needed, to make that segment draggable
+    static PathPlan simplifyPath(PathPlan const& path);
+
+    // Plan that is used when no route was found, and while the router is still busy
+    static PathPlan getDefaultPath(Point<float> start, Point<float> end);
+
+private:
+    struct Request {
+        Component::SafePointer<Connection> connection;
+        int generation;
+        Point<float> start, end;
+        Rectangle<int> cellArea;
+        std::vector<uint8> blocked;
+    };
+
+    // Beyond this the search area gets too big to route interactively, the default path is used instead
+    static constexpr int maxCells = 512 * 512;
+
+    // Extra space around the start and end points that a route can use to get around obstacles
+    static constexpr int searchMargin = 128;
+
+    // Extra cost for every corner, so we prefer routes with fewer bends
+    static constexpr int bendCost = 4;
+
+    // Every canvas has a router, including the ones inside graphs, so they all share one routing thread
+    // Jobs don't refer back to the router that started them, results only go to connections that still exist
+    struct RoutingThread : public ThreadPool {
+        RoutingThread()
+            : ThreadPool(1)
+        {
+        }
+    };
+
+    Canvas* cnv;
+    SharedResourcePointer<RoutingThread> pool;
+
+    JUCE_DECLARE_NON_COPYABLE(ConnectionRouter)
+};
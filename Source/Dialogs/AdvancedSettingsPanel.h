@@ -14,13 +14,17 @@ public:
         auto* settingsFile = SettingsFile::getInstance();
         nativeTitlebar.referTo(settingsFile->getPropertyAsValue("native_window"));
         reloadPatch.referTo(settingsFile->getPropertyAsValue("reload_last_state"));
+        batchedRendering.referTo(settingsFile->getPropertyAsValue("batched_rendering"));
 
         useNativeTitlebar.reset(new PropertiesPanel::BoolComponent("Use system titlebar", nativeTitlebar, { "No", "Yes" }));
 
         reloadLastOpenedPatch.reset(new PropertiesPanel::BoolComponent("Reload last opened patch on startup", reloadPatch, { "No", "Yes" }));
 
+        useBatchedRendering.reset(new PropertiesPanel::BoolComponent("Batched canvas rendering (for newly opened patches)", batchedRendering, { "No", "Yes" }));
+
         addAndMakeVisible(*useNativeTitlebar);
         addAndMakeVisible(*reloadLastOpenedPatch);
+        addAndMakeVisible(*useBatchedRendering);
     }
 
     void resized() override
@@ -28,13 +32,16 @@ public:
         auto bounds = getLocalBounds();
         useNativeTitlebar->setBounds(bounds.removeFromTop(23));
         reloadLastOpenedPatch->setBounds(bounds.removeFromTop(23));
+        useBatchedRendering->setBounds(bounds.removeFromTop(23));
     }
 
     ValueTree settingsTree;
 
     Value nativeTitlebar;
     Value reloadPatch;
+    Value batchedRendering;
 
     std::unique_ptr<PropertiesPanel::BoolComponent> useNativeTitlebar;
     std::unique_ptr<PropertiesPanel::BoolComponent> reloadLastOpenedPatch;
+    std::unique_ptr<PropertiesPanel::BoolComponent> useBatchedRendering;
 };
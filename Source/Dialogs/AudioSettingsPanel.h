@@ -1127,7 +1127,8 @@ public:
 #else
 
 class DAWAudioSettings : public Component
-    , public Value::Listener {
+    , public Value::Listener
+    , public Timer {
 
 public:
     explicit DAWAudioSettings(AudioProcessor* p)
@@ -1143,11 +1144,17 @@ public:
 
         nativeDialogToggle = std::make_unique<PropertiesPanel::BoolComponent>("Use system dialog", nativeDialogValue, std::vector<String> { "No", "Yes" });
 
+        blockSizeCombo = std::make_unique<PropertiesPanel::ComboComponent>("Block size (samples)", blockSizeValue, std::vector<String> { "64", "128", "256" });
+        zeroLatencyToggle = std::make_unique<PropertiesPanel::BoolComponent>("Zero latency", zeroLatencyValue, std::vector<String> { "No", "Yes" });
+
         addAndMakeVisible(latencyNumberBox);
         addAndMakeVisible(tailLengthNumberBox);
+        addAndMakeVisible(*blockSizeCombo);
+        addAndMakeVisible(*zeroLatencyToggle);
         addAndMakeVisible(*nativeDialogToggle);
 
-        dynamic_cast<DraggableNumber*>(latencyNumberBox.label.get())->setMinimum(64);
+        // Zero latency mode can legitimately report no latency at all
+        dynamic_cast<DraggableNumber*>(latencyNumberBox.label.get())->setMinimum(0);
 
         auto* proc = dynamic_cast<PluginProcessor*>(processor);
 
@@ -1157,7 +1164,34 @@ public:
         latencyValue.addListener(this);
         nativeDialogValue.addListener(this);
 
-        latencyValue = proc->getLatencySamples();
+        latencyValue = proc->getBaseLatency();
+
+        // Block sizes are 64 << (id - 1)
+        blockSizeValue = static_cast<int>(std::log2(proc->dspBlockSize.load() / 64)) + 1;
+        zeroLatencyValue = proc->zeroLatencyMode.load();
+
+        blockSizeValue.addListener(this);
+        zeroLatencyValue.addListener(this);
+
+        // The audio thread can find out at any time that the host block size doesn't allow zero latency processing
+        timerCallback();
+        startTimer(500);
+    }
+
+    void timerCallback() override
+    {
+        auto* proc = dynamic_cast<PluginProcessor*>(processor);
+        auto const fallback = proc->zeroLatencyFallback.load();
+
+        if (fallback == showingFallback)
+            return;
+
+        showingFallback = fallback;
+        zeroLatencyToggle->setName(fallback ? "Zero latency (inactive)" : "Zero latency");
+        zeroLatencyToggle->setTooltip(fallback ? "The host block size is not a multiple of the DSP block size, so audio is buffered with one block of latency" : String());
+        zeroLatencyToggle->repaint();
+
+        latencyValue = proc->getBaseLatency();
     }
 
     void resized() override
@@ -1165,13 +1199,28 @@ public:
         auto bounds = getLocalBounds();
         latencyNumberBox.setBounds(bounds.removeFromTop(23));
         tailLengthNumberBox.setBounds(bounds.removeFromTop(23));
+        blockSizeCombo->setBounds(bounds.removeFromTop(23));
+        zeroLatencyToggle->setBounds(bounds.removeFromTop(23));
         nativeDialogToggle->setBounds(bounds.removeFromTop(23));
     }
 
     void valueChanged(Value& v) override
     {
+        auto* proc = dynamic_cast<PluginProcessor*>(processor);
+
         if (v.refersToSameSourceAs(latencyValue)) {
-            processor->setLatencySamples(static_cast<int>(latencyValue.getValue()));
+            // Only a change by the user makes it a custom latency, not us showing the current value
+            if (static_cast<int>(latencyValue.getValue()) != proc->getBaseLatency())
+                proc->setBaseLatency(static_cast<int>(latencyValue.getValue()));
+        } else if (v.refersToSameSourceAs(blockSizeValue)) {
+            // Changing how we buffer changes the real latency, so report that instead of what was set before
+            proc->setDSPBlockSize(64 << (static_cast<int>(blockSizeValue.getValue()) - 1));
+            proc->setBaseLatency(-1);
+            latencyValue = proc->getBaseLatency();
+        } else if (v.refersToSameSourceAs(zeroLatencyValue)) {
+            proc->setZeroLatencyMode(static_cast<bool>(zeroLatencyValue.getValue()));
+            proc->setBaseLatency(-1);
+            latencyValue = proc->getBaseLatency();
         }
     }
 
@@ -1180,10 +1229,16 @@ public:
     Value latencyValue;
     Value tailLengthValue;
     Value nativeDialogValue;
+    Value blockSizeValue;
+    Value zeroLatencyValue;
+
+    bool showingFallback = false;
 
     PropertiesPanel::EditableComponent<int> latencyNumberBox = PropertiesPanel::EditableComponent<int>("Latency (samples)", latencyValue);
     PropertiesPanel::EditableComponent<float> tailLengthNumberBox = PropertiesPanel::EditableComponent<float>("Tail length (seconds)", tailLengthValue);
 
+    std::unique_ptr<PropertiesPanel::ComboComponent> blockSizeCombo;
+    std::unique_ptr<PropertiesPanel::BoolComponent> zeroLatencyToggle;
     std::unique_ptr<PropertiesPanel::BoolComponent> nativeDialogToggle;
 };
 
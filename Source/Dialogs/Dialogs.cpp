@@ -337,6 +337,7 @@ void Dialogs::showCanvasRightClickMenu(Canvas* cnv, Component* originalComponent
                     }
                 }
             }
+            cnv->renderer->toBack();
             cnv->patch.endUndoSequence("ToBack");
             cnv->synchronise();
             break;
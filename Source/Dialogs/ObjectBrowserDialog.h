@@ -311,7 +311,7 @@ public:
             return;
         }
 
-        auto ioletDescriptions = library.getIoletDescriptions()[name];
+        auto ioletDescriptions = library.getIoletDescriptions(name);
         auto& inletDescriptions = ioletDescriptions[0];
         auto& outletDescriptions = ioletDescriptions[1];
 
@@ -340,11 +340,10 @@ public:
         categories = "";
         origin = "";
 
-        // Inverse lookup :(
-        for (auto const& [cat, objects] : library.getObjectCategories()) {
-            if (pd::Library::objectOrigins.contains(cat) && objects.contains(name)) {
+        for (auto const& cat : library.getObjectCategories(name)) {
+            if (pd::Library::objectOrigins.contains(cat)) {
                 origin = cat;
-            } else if (objects.contains(name)) {
+            } else {
                 categories += cat + ", ";
             }
         }
@@ -359,7 +358,7 @@ public:
             origin = "Unknown";
         }
 
-        description = library.getObjectDescriptions()[name];
+        description = library.getObjectDescription(name);
 
         if (description.isEmpty()) {
             description = "No description available";
@@ -180,10 +180,10 @@ public:
             return;
         }
 
-        auto const ioletDescriptions = library.getIoletDescriptions()[name];
+        auto const ioletDescriptions = library.getIoletDescriptions(name);
         auto const& inletDescriptions = ioletDescriptions[0];
         auto const& outletDescriptions = ioletDescriptions[1];
-        auto methods = library.getMethods()[name];
+        auto methods = library.getMethods(name);
 
         inlets.resize(inletDescriptions.size());
         outlets.resize(outletDescriptions.size());
@@ -210,11 +210,10 @@ public:
         categories = "";
         origin = "";
 
-        // Inverse lookup :(
-        for (auto const& [cat, objects] : library.getObjectCategories()) {
-            if (pd::Library::objectOrigins.contains(cat) && objects.contains(name)) {
+        for (auto const& cat : library.getObjectCategories(name)) {
+            if (pd::Library::objectOrigins.contains(cat)) {
                 origin = cat;
-            } else if (objects.contains(name)) {
+            } else {
                 categories += cat + ", ";
             }
         }
@@ -229,7 +228,7 @@ public:
             origin = "Unknown";
         }
 
-        description = library.getObjectDescriptions()[name];
+        description = library.getObjectDescription(name);
 
         if (description.isEmpty()) {
             description = "No description available";
@@ -239,7 +238,7 @@ public:
 
         String rightSideInfoText;
 
-        auto arguments = library.getArguments()[name];
+        auto arguments = library.getArguments(name);
 
         if (arguments.size())
             rightSideInfoText += "Arguments:";
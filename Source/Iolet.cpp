@@ -75,6 +75,10 @@ void Iolet::paint(Graphics& g)
     bool down = isMouseButtonDown();
     bool over = isMouseOver();
 
+    // The canvas renderer draws iolets in their resting state, so we only need to draw while interacting
+    if (cnv->renderer->isBatched(object) && (isLocked || !(down || over || isTargeted || object->isMouseOverOrDragging(true))))
+        return;
+
     if ((!isTargeted && !over) || isLocked) {
         bounds = bounds.reduced(2);
     }
@@ -412,9 +416,9 @@ Array<Connection*> Iolet::getConnections()
 
 Iolet* Iolet::findNearestIolet(Canvas* cnv, Point<int> position, bool inlet, Object* boxToExclude)
 {
-    // Find all iolets
+    // Find all iolets of objects that are close enough
     Array<Iolet*> allEdges;
-    for (auto* object : cnv->objects) {
+    for (auto* object : cnv->objectIndex.query(Rectangle<int>(position, position).expanded(51))) {
         for (auto* iolet : object->iolets) {
             if (iolet->isInlet == inlet && iolet->object != boxToExclude) {
                 allEdges.add(iolet);
@@ -37,6 +37,7 @@ public:
     void createConnection();
         
     void setHidden(bool hidden);
+    bool isHidden() const { return hideIolet; }
 
     void clearConnections();
     Array<Connection*> getConnections();
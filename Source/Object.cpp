@@ -65,6 +65,9 @@ Object::Object(void* object, Canvas* parent)
 Object::~Object()
 {
     cnv->editor->removeModifierKeyListener(this);
+    cnv->objectIndex.remove(this);
+    cnv->obstacleMap.remove(this);
+    cnv->renderer->remove(this);
     
     if (attachedToMouse) {
         stopTimer();
@@ -324,8 +327,20 @@ Array<Rectangle<float>> Object::getCorners() const
     return corners;
 }
 
+void Object::setDSPLoad(float load)
+{
+    if (std::exchange(dspLoad, load) != load)
+        repaint();
+}
+
 void Object::paintOverChildren(Graphics& g)
 {
+    // Profiler heatmap: goes from green for cheap objects to red for the most expensive object in the patch
+    if (dspLoad > 0.0f) {
+        g.setColour(Colours::green.interpolatedWith(Colours::red, dspLoad).withAlpha(0.35f));
+        g.fillRoundedRectangle(getLocalBounds().toFloat().reduced(Object::margin + 1.0f), PlugDataLook::objectCornerRadius);
+    }
+
     if (isSearchTarget) {
         g.saveState();
 
@@ -403,8 +418,18 @@ void Object::paint(Graphics& g)
     }
 }
 
+void Object::moved()
+{
+    cnv->objectIndex.update(this, getBounds());
+    cnv->obstacleMap.update(this, getBounds());
+    cnv->renderer->update(this);
+}
+
 void Object::resized()
 {
+    cnv->objectIndex.update(this, getBounds());
+    cnv->obstacleMap.update(this, getBounds());
+
     setVisible(!((cnv->isGraph || cnv->presentationMode == var(true)) && gui && gui->hideInGraph()));
 
     if (gui) {
@@ -455,6 +480,9 @@ void Object::resized()
 
         index++;
     }
+
+    // Needs the final iolet positions
+    cnv->renderer->update(this);
 }
 
 void Object::updateTooltips()
@@ -537,6 +565,27 @@ void Object::updateTooltips()
     }
 }
 
+bool Object::ioletsNeedUpdate() const
+{
+    auto* ptr = pd::Patch::checkObject(getPointer());
+    if (!ptr)
+        return false;
+
+    if (libpd_ninlets(ptr) != numInputs || libpd_noutlets(ptr) != numOutputs || iolets.size() != numInputs + numOutputs)
+        return true;
+
+    for (int i = 0; i < iolets.size(); i++) {
+        auto* iolet = iolets[i];
+        auto const isSignal = i < numInputs ? libpd_issignalinlet(ptr, i) : libpd_issignaloutlet(ptr, i - numInputs);
+        auto const shouldBeHidden = gui && (iolet->isInlet ? gui->hideInlets() : gui->hideOutlets());
+
+        if (iolet->isSignal != static_cast<bool>(isSignal) || iolet->isHidden() != shouldBeHidden)
+            return true;
+    }
+
+    return false;
+}
+
 void Object::updateIolets()
 {
     if (!getPointer())
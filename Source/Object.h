@@ -38,9 +38,13 @@ public:
     void paint(Graphics&) override;
     void paintOverChildren(Graphics&) override;
     void resized() override;
+    void moved() override;
 
     void updateIolets();
 
+    // Cheap check against pd to see whether updateIolets has anything to do
+    bool ioletsNeedUpdate() const;
+
     void setType(String const& newType, void* existingObject = nullptr);
     void updateBounds();
 
@@ -53,6 +57,9 @@ public:
     void openHelpPatch() const;
     void* getPointer() const;
 
+    // Relative DSP cost between 0 and 1 for the profiler heatmap, 0 hides it
+    void setDSPLoad(float load);
+
     Array<Connection*> getConnections() const;
 
     void mouseEnter(MouseEvent const& e) override;
@@ -123,6 +130,8 @@ private:
     bool indexShown = false;
     bool isHvccCompatible = true;
 
+    float dspLoad = 0.0f;
+
     bool wasResized = false;
 
     std::unique_ptr<TextEditor> newObjectEditor;
@@ -473,7 +473,7 @@ Array<Object*> ObjectGrid::getSnappableObjects(Object* draggedObject)
 
     auto viewBounds = reinterpret_cast<Viewport*>(cnv->viewport)->getViewArea();
 
-    for (auto* object : cnv->objects) {
+    for (auto* object : cnv->objectIndex.query(viewBounds)) {
         if (draggedObject == object || cnv->isSelected(object) || !viewBounds.intersects(object->getBounds()))
             continue; // don't look at dragged object, selected objects, or objects that are outside of view bounds
 
@@ -332,16 +332,8 @@ void ObjectBase::stopEdition()
 
 void ObjectBase::sendFloatValue(float newValue)
 {
-    pd->enqueueFunction([newValue, patch = &cnv->patch, ptr = this->ptr](){
-        
-        if(patch->objectWasDeleted(ptr)) return;
-        
-        t_atom atom;
-        SETFLOAT(&atom, newValue);
-        pd_typedmess(static_cast<t_pd*>(ptr), patch->instance->generateSymbol("set"), 1, &atom);
-        pd_bang(static_cast<t_pd*>(ptr));
-    });
-
+    // Sets the value and bangs the object on the audio thread, repeated values within one tick get coalesced
+    pd->enqueueFloatValue(ptr, newValue, &cnv->patch);
 }
 
 ObjectBase* ObjectBase::createGui(void* ptr, Object* parent)
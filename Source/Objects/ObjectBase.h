@@ -7,6 +7,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <optional>
 
 #include "PluginProcessor.h"
 #include "Sidebar/Sidebar.h"
@@ -66,6 +67,16 @@ public:
     virtual void showEditor() {};
     virtual void hideEditor() {};
 
+    // Objects that are nothing but a text box can hand their contents to the canvas renderer, which draws them in a single batch
+    struct BatchedText {
+        String text;
+        int numLines;
+        bool isValid;
+        BorderSize<int> border;
+    };
+
+    virtual std::optional<BatchedText> getBatchedText() { return std::nullopt; }
+
     // Some objects need to show/hide iolets when send/receive symbols are set
     virtual bool hideInlets() { return false; }
     virtual bool hideOutlets() { return false; }
@@ -179,6 +179,10 @@ public:
 
     void paint(Graphics& g) override
     {
+        // Drawn by the canvas renderer
+        if (cnv->renderer->isBatched(object))
+            return;
+
         auto backgroundColour = object->findColour(PlugDataColour::textObjectBackgroundColourId);
         g.setColour(backgroundColour);
         g.fillRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), PlugDataLook::objectCornerRadius);
@@ -201,6 +205,9 @@ public:
 
     void paintOverChildren(Graphics& g) override
     {
+        if (cnv->renderer->isBatched(object))
+            return;
+
         bool selected = cnv->isSelected(object) && !cnv->isGraph;
 
         auto outlineColour = object->findColour(selected ? PlugDataColour::objectSelectedOutlineColourId : objectOutlineColourId);
@@ -321,6 +328,14 @@ public:
         return editor != nullptr;
     }
 
+    std::optional<BatchedText> getBatchedText() override
+    {
+        if (editor)
+            return std::nullopt;
+
+        return BatchedText { objectText, numLines, isValid, border };
+    }
+
     void showEditor() override
     {
         if (editor == nullptr) {
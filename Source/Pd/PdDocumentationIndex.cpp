@@ -0,0 +1,380 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "PdDocumentationIndex.h"
+
+namespace pd {
+
+bool DocumentationIndex::write(File const& indexFile, String const& fingerprint, Documentation const& documentation)
+{
+    // Every string is stored once, offset 0 is the empty string
+    std::string strings(1, '\0');
+    std::unordered_map<std::string, uint32> stringOffsets = { { std::string(), 0 } };
+    auto addString = [&](String const& string) -> uint32 {
+        auto const utf8 = string.toStdString();
+        if (auto it = stringOffsets.find(utf8); it != stringOffsets.end())
+            return it->second;
+
+        auto const offset = static_cast<uint32>(strings.size());
+        strings.append(utf8);
+        strings.push_back('\0');
+        stringOffsets[utf8] = offset;
+        return offset;
+    };
+
+    // Everything that is documented, sorted so we can use binary search on the names
+    StringArray names;
+    for (auto const& [name, description] : documentation.descriptions)
+        names.add(name);
+    for (auto const& [name, iolets] : documentation.iolets)
+        names.add(name);
+    for (auto const& [name, arguments] : documentation.arguments)
+        names.add(name);
+    for (auto const& [name, methods] : documentation.methods)
+        names.add(name);
+    for (auto const& [category, objects] : documentation.categories)
+        names.addArray(objects);
+
+    auto const compareNames = [](String const& a, String const& b) { return std::strcmp(a.toRawUTF8(), b.toRawUTF8()) < 0; };
+    names.removeDuplicates(false);
+    std::sort(names.begin(), names.end(), compareNames);
+
+    std::vector<String> categoryNames;
+    for (auto const& [category, objects] : documentation.categories)
+        categoryNames.push_back(category);
+
+    std::sort(categoryNames.begin(), categoryNames.end());
+
+    std::vector<ObjectRecord> objects;
+    std::vector<CategoryRecord> categories;
+    std::vector<ArgumentRecord> arguments;
+    std::vector<MethodRecord> methods;
+    std::vector<IoletRecord> iolets;
+    std::vector<uint32> indices;
+
+    auto addIolets = [&](IODescription const& descriptions) {
+        for (auto const& [tooltip, repeating] : descriptions) {
+            iolets.push_back({ addString(tooltip), static_cast<uint32>(repeating) });
+        }
+    };
+
+    for (auto const& name : names) {
+        ObjectRecord record = {};
+        record.name = addString(name);
+
+        if (auto it = documentation.descriptions.find(name); it != documentation.descriptions.end())
+            record.description = addString(it->second);
+
+        record.firstArgument = static_cast<uint32>(arguments.size());
+        if (auto it = documentation.arguments.find(name); it != documentation.arguments.end()) {
+            for (auto const& [type, description, defaultValue] : it->second) {
+                arguments.push_back({ addString(type), addString(description), addString(defaultValue) });
+            }
+        }
+        record.numArguments = static_cast<uint32>(arguments.size()) - record.firstArgument;
+
+        record.firstMethod = static_cast<uint32>(methods.size());
+        if (auto it = documentation.methods.find(name); it != documentation.methods.end()) {
+            for (auto const& [type, description] : it->second) {
+                methods.push_back({ addString(type), addString(description) });
+            }
+        }
+        record.numMethods = static_cast<uint32>(methods.size()) - record.firstMethod;
+
+        if (auto it = documentation.iolets.find(name); it != documentation.iolets.end()) {
+            record.firstInlet = static_cast<uint32>(iolets.size());
+            addIolets(it->second[0]);
+            record.numInlets = static_cast<uint32>(iolets.size()) - record.firstInlet;
+
+            record.firstOutlet = static_cast<uint32>(iolets.size());
+            addIolets(it->second[1]);
+            record.numOutlets = static_cast<uint32>(iolets.size()) - record.firstOutlet;
+        }
+
+        record.firstCategory = static_cast<uint32>(indices.size());
+        for (uint32 i = 0; i < static_cast<uint32>(categoryNames.size()); i++) {
+            if (documentation.categories.at(categoryNames[i]).contains(name))
+                indices.push_back(i);
+        }
+        record.numCategories = static_cast<uint32>(indices.size()) - record.firstCategory;
+
+        objects.push_back(record);
+    }
+
+    for (auto const& category : categoryNames) {
+        CategoryRecord record = { addString(category), static_cast<uint32>(indices.size()), 0 };
+
+        for (auto const& object : documentation.categories.at(category)) {
+            auto const it = std::lower_bound(names.begin(), names.end(), object, compareNames);
+            indices.push_back(static_cast<uint32>(it - names.begin()));
+        }
+
+        record.numObjects = static_cast<uint32>(indices.size()) - record.firstObject;
+        categories.push_back(record);
+    }
+
+    Header newHeader = {};
+    newHeader.magic = magic;
+    newHeader.version = version;
+    newHeader.fingerprint = addString(fingerprint);
+    newHeader.numObjects = static_cast<uint32>(objects.size());
+    newHeader.numCategories = static_cast<uint32>(categories.size());
+
+    auto offset = static_cast<uint32>(sizeof(Header));
+    auto place = [&offset](uint32& position, size_t numBytes) {
+        position = offset;
+        offset += static_cast<uint32>(numBytes);
+    };
+
+    place(newHeader.objects, objects.size() * sizeof(ObjectRecord));
+    place(newHeader.categories, categories.size() * sizeof(CategoryRecord));
+    place(newHeader.arguments, arguments.size() * sizeof(ArgumentRecord));
+    place(newHeader.methods, methods.size() * sizeof(MethodRecord));
+    place(newHeader.iolets, iolets.size() * sizeof(IoletRecord));
+    place(newHeader.indices, indices.size() * sizeof(uint32));
+    place(newHeader.strings, strings.size());
+
+    // String offsets are relative to the string table until here
+    auto const stringBase = newHeader.strings;
+    newHeader.fingerprint += stringBase;
+    for (auto& record : objects) {
+        record.name += stringBase;
+        record.description += stringBase;
+    }
+    for (auto& record : categories)
+        record.name += stringBase;
+    for (auto& record : arguments) {
+        record.type += stringBase;
+        record.description += stringBase;
+        record.defaultValue += stringBase;
+    }
+    for (auto& record : methods) {
+        record.type += stringBase;
+        record.description += stringBase;
+    }
+    for (auto& record : iolets)
+        record.tooltip += stringBase;
+
+    TemporaryFile tempFile(indexFile);
+    {
+        FileOutputStream ostream(tempFile.getFile());
+        if (!ostream.openedOk())
+            return false;
+
+        ostream.write(&newHeader, sizeof(Header));
+        ostream.write(objects.data(), objects.size() * sizeof(ObjectRecord));
+        ostream.write(categories.data(), categories.size() * sizeof(CategoryRecord));
+        ostream.write(arguments.data(), arguments.size() * sizeof(ArgumentRecord));
+        ostream.write(methods.data(), methods.size() * sizeof(MethodRecord));
+        ostream.write(iolets.data(), iolets.size() * sizeof(IoletRecord));
+        ostream.write(indices.data(), indices.size() * sizeof(uint32));
+        ostream.write(strings.data(), strings.size());
+
+        if (ostream.getStatus().failed())
+            return false;
+    }
+
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+bool DocumentationIndex::load(File const& indexFile, String const& fingerprint)
+{
+    mappedFile.reset();
+    data = nullptr;
+    size = 0;
+
+    auto newFile = std::make_unique<MemoryMappedFile>(indexFile, MemoryMappedFile::readOnly);
+    auto const* newData = static_cast<char const*>(newFile->getData());
+    auto const newSize = newFile->getSize();
+
+    if (!newData || newSize < sizeof(Header) || newData[newSize - 1] != '\0')
+        return false;
+
+    Header newHeader;
+    std::memcpy(&newHeader, newData, sizeof(Header));
+
+    // All regions follow each other, so checking that they are in order and end inside of the file is enough
+    auto const regionsInOrder = newHeader.objects <= newHeader.categories && newHeader.categories <= newHeader.arguments && newHeader.arguments <= newHeader.methods
+        && newHeader.methods <= newHeader.iolets && newHeader.iolets <= newHeader.indices && newHeader.indices <= newHeader.strings && newHeader.strings < newSize;
+
+    if (newHeader.magic != magic || newHeader.version != version || !regionsInOrder)
+        return false;
+
+    if (newHeader.objects + static_cast<size_t>(newHeader.numObjects) * sizeof(ObjectRecord) > newHeader.categories
+        || newHeader.categories + static_cast<size_t>(newHeader.numCategories) * sizeof(CategoryRecord) > newHeader.arguments)
+        return false;
+
+    mappedFile = std::move(newFile);
+    data = newData;
+    size = newSize;
+    header = newHeader;
+
+    if (getString(header.fingerprint) != fingerprint) {
+        mappedFile.reset();
+        data = nullptr;
+        size = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool DocumentationIndex::isLoaded() const
+{
+    return data != nullptr;
+}
+
+template<typename RecordType>
+RecordType DocumentationIndex::getRecord(uint32 offset, uint32 index) const
+{
+    RecordType record = {};
+    auto const position = offset + static_cast<size_t>(index) * sizeof(RecordType);
+    if (position + sizeof(RecordType) <= header.strings)
+        std::memcpy(&record, data + position, sizeof(RecordType));
+
+    return record;
+}
+
+String DocumentationIndex::getString(uint32 offset) const
+{
+    return String::fromUTF8(getRawString(offset));
+}
+
+char const* DocumentationIndex::getRawString(uint32 offset) const
+{
+    if (offset < header.strings || offset >= size)
+        return "";
+
+    return data + offset;
+}
+
+std::optional<DocumentationIndex::ObjectRecord> DocumentationIndex::findObject(String const& name) const
+{
+    if (!isLoaded())
+        return std::nullopt;
+
+    auto const* key = name.toRawUTF8();
+
+    uint32 low = 0;
+    uint32 high = header.numObjects;
+    while (low < high) {
+        auto const middle = low + (high - low) / 2;
+        auto const record = getRecord<ObjectRecord>(header.objects, middle);
+        auto const comparison = std::strcmp(getRawString(record.name), key);
+
+        if (comparison == 0)
+            return record;
+
+        if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return std::nullopt;
+}
+
+String DocumentationIndex::getDescription(String const& name) const
+{
+    if (auto object = findObject(name))
+        return getString(object->description);
+
+    return {};
+}
+
+std::array<IODescription, 2> DocumentationIndex::getIoletDescriptions(String const& name) const
+{
+    std::array<IODescription, 2> result;
+
+    if (auto object = findObject(name)) {
+        for (uint32 i = 0; i < object->numInlets; i++) {
+            auto const iolet = getRecord<IoletRecord>(header.iolets, object->firstInlet + i);
+            result[0].add({ getString(iolet.tooltip), iolet.repeating != 0 });
+        }
+        for (uint32 i = 0; i < object->numOutlets; i++) {
+            auto const iolet = getRecord<IoletRecord>(header.iolets, object->firstOutlet + i);
+            result[1].add({ getString(iolet.tooltip), iolet.repeating != 0 });
+        }
+    }
+
+    return result;
+}
+
+Arguments DocumentationIndex::getArguments(String const& name) const
+{
+    Arguments result;
+
+    if (auto object = findObject(name)) {
+        for (uint32 i = 0; i < object->numArguments; i++) {
+            auto const argument = getRecord<ArgumentRecord>(header.arguments, object->firstArgument + i);
+            result.push_back({ getString(argument.type), getString(argument.description), getString(argument.defaultValue) });
+        }
+    }
+
+    return result;
+}
+
+Methods DocumentationIndex::getMethods(String const& name) const
+{
+    Methods result;
+
+    if (auto object = findObject(name)) {
+        for (uint32 i = 0; i < object->numMethods; i++) {
+            auto const method = getRecord<MethodRecord>(header.methods, object->firstMethod + i);
+            result.push_back({ getString(method.type), getString(method.description) });
+        }
+    }
+
+    return result;
+}
+
+StringArray DocumentationIndex::getCategories(String const& name) const
+{
+    StringArray result;
+
+    if (auto object = findObject(name)) {
+        for (uint32 i = 0; i < object->numCategories; i++) {
+            auto const categoryIndex = getRecord<uint32>(header.indices, object->firstCategory + i);
+            result.add(getString(getRecord<CategoryRecord>(header.categories, categoryIndex).name));
+        }
+    }
+
+    return result;
+}
+
+StringArray DocumentationIndex::getObjectNames() const
+{
+    StringArray result;
+
+    for (uint32 i = 0; isLoaded() && i < header.numObjects; i++) {
+        result.add(getString(getRecord<ObjectRecord>(header.objects, i).name));
+    }
+
+    return result;
+}
+
+CategoryMap DocumentationIndex::getAllCategories() const
+{
+    CategoryMap result;
+
+    for (uint32 i = 0; isLoaded() && i < header.numCategories; i++) {
+        auto const category = getRecord<CategoryRecord>(header.categories, i);
+        auto& objects = result[getString(category.name)];
+
+        for (uint32 j = 0; j < category.numObjects; j++) {
+            auto const objectIndex = getRecord<uint32>(header.indices, category.firstObject + j);
+            objects.add(getString(getRecord<ObjectRecord>(header.objects, objectIndex).name));
+        }
+    }
+
+    return result;
+}
+
+}
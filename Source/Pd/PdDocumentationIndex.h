@@ -0,0 +1,112 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace pd {
+
+using IODescription = Array<std::pair<String, bool>>;
+using IODescriptionMap = std::unordered_map<String, std::array<IODescription, 2>>;
+
+using Arguments = std::vector<std::tuple<String, String, String>>;
+using ArgumentMap = std::unordered_map<String, Arguments>;
+
+using Methods = std::vector<std::pair<String, String>>;
+using MethodMap = std::unordered_map<String, Methods>;
+
+using ObjectMap = std::unordered_map<String, String>;
+using CategoryMap = std::unordered_map<String, StringArray>;
+
+// The parsed object documentation, stored in a file that gets memory mapped
+// Parsing all the markdown files takes a while, so we only do that when the documentation changed, and every plugin instance shares the mapped pages
+// Layout: a header, fixed size records that refer to each other by index and to strings by offset, and a table of null terminated strings at the end
+class DocumentationIndex {
+
+public:
+    struct Documentation {
+        ObjectMap descriptions;
+        CategoryMap categories;
+        IODescriptionMap iolets;
+        ArgumentMap arguments;
+        MethodMap methods;
+    };
+
+    // Writes the index to a temporary file first, so other instances never see a half written index
+    static bool write(File const& indexFile, String const& fingerprint, Documentation const& documentation);
+
+    // Fails if the file doesn't exist, is damaged, or was made from different documentation
+    bool load(File const& indexFile, String const& fingerprint);
+
+    bool isLoaded() const;
+
+    String getDescription(String const& name) const;
+    std::array<IODescription, 2> getIoletDescriptions(String const& name) const;
+    Arguments getArguments(String const& name) const;
+    Methods getMethods(String const& name) const;
+    StringArray getCategories(String const& name) const;
+
+    StringArray getObjectNames() const;
+    CategoryMap getAllCategories() const;
+
+private:
+    static constexpr uint32 magic = 0x434f4450; // "PDOC"
+    static constexpr uint32 version = 1;
+
+    struct Header {
+        uint32 magic, version, fingerprint;
+        uint32 numObjects, objects;
+        uint32 numCategories, categories;
+        uint32 arguments, methods, iolets, indices;
+        uint32 strings;
+    };
+
+    struct ObjectRecord {
+        uint32 name, description;
+        uint32 firstArgument, numArguments;
+        uint32 firstMethod, numMethods;
+        uint32 firstInlet, numInlets;
+        uint32 firstOutlet, numOutlets;
+        uint32 firstCategory, numCategories; // Into the indices array
+    };
+
+    struct CategoryRecord {
+        uint32 name;
+        uint32 firstObject, numObjects; // Into the indices array
+    };
+
+    struct ArgumentRecord {
+        uint32 type, description, defaultValue;
+    };
+
+    struct MethodRecord {
+        uint32 type, description;
+    };
+
+    struct IoletRecord {
+        uint32 tooltip, repeating;
+    };
+
+    template<typename RecordType>
+    RecordType getRecord(uint32 offset, uint32 index) const;
+
+    String getString(uint32 offset) const;
+    char const* getRawString(uint32 offset) const; // Points into the mapped file, the file always ends with a null terminator
+    std::optional<ObjectRecord> findObject(String const& name) const;
+
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+    char const* data = nullptr;
+    size_t size = 0;
+    Header header = {};
+};
+
+}
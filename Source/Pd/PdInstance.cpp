@@ -23,79 +23,70 @@ void set_class_prefix(t_symbol* dir);
 
 struct pd::Instance::internal {
 
+    // Receiver names and selectors always come from symbols that already exist, so these lookups never allocate
     static void instance_multi_bang(pd::Instance* ptr, char const* recv)
     {
-        ptr->enqueueFunctionAsync([ptr, recv]() { ptr->processMessage({ String("bang"), String::fromUTF8(recv) }); });
+        ptr->messageDispatcher.enqueue(gensym(recv), &s_bang, 0, nullptr);
     }
 
     static void instance_multi_float(pd::Instance* ptr, char const* recv, float f)
     {
-        ptr->enqueueFunctionAsync([ptr, recv, f]() mutable { ptr->processMessage({ String("float"), String::fromUTF8(recv), std::vector<Atom>(1, { f }) }); });
+        t_atom atom;
+        SETFLOAT(&atom, f);
+        ptr->messageDispatcher.enqueue(gensym(recv), &s_float, 1, &atom);
     }
 
     static void instance_multi_symbol(pd::Instance* ptr, char const* recv, char const* sym)
     {
-        ptr->enqueueFunctionAsync([ptr, recv, sym]() mutable { ptr->processMessage({ String("symbol"), String::fromUTF8(recv), std::vector<Atom>(1, String::fromUTF8(sym)) }); });
+        t_atom atom;
+        SETSYMBOL(&atom, gensym(sym));
+        ptr->messageDispatcher.enqueue(gensym(recv), &s_symbol, 1, &atom);
     }
 
     static void instance_multi_list(pd::Instance* ptr, char const* recv, int argc, t_atom* argv)
     {
-        Message mess { String("list"), String::fromUTF8(recv), std::vector<Atom>(argc) };
-        for (int i = 0; i < argc; ++i) {
-            if (argv[i].a_type == A_FLOAT)
-                mess.list[i] = Atom(atom_getfloat(argv + i));
-            else if (argv[i].a_type == A_SYMBOL)
-                mess.list[i] = Atom(String::fromUTF8(atom_getsymbol(argv + i)->s_name));
-        }
-
-        ptr->enqueueFunctionAsync([ptr, mess]() mutable { ptr->processMessage(mess); });
+        ptr->messageDispatcher.enqueue(gensym(recv), &s_list, argc, argv);
     }
 
     static void instance_multi_message(pd::Instance* ptr, char const* recv, char const* msg, int argc, t_atom* argv)
     {
-        Message mess { msg, String::fromUTF8(recv), std::vector<Atom>(argc) };
-        for (int i = 0; i < argc; ++i) {
-            if (argv[i].a_type == A_FLOAT)
-                mess.list[i] = Atom(atom_getfloat(argv + i));
-            else if (argv[i].a_type == A_SYMBOL)
-                mess.list[i] = Atom(String::fromUTF8(atom_getsymbol(argv + i)->s_name));
-        }
-        ptr->enqueueFunctionAsync([ptr, mess]() mutable { ptr->processMessage(std::move(mess)); });
+        ptr->messageDispatcher.enqueue(gensym(recv), gensym(msg), argc, argv);
     }
 
+    // MIDI hooks get called from within Pd, with Pd locked, so they can write their output directly
     static void instance_multi_noteon(pd::Instance* ptr, int channel, int pitch, int velocity)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, pitch, velocity]() mutable { ptr->processMidiEvent({ midievent::NOTEON, channel, pitch, velocity }); });
+        ptr->processMidiEvent({ midievent::NOTEON, channel, pitch, velocity });
     }
 
     static void instance_multi_controlchange(pd::Instance* ptr, int channel, int controller, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, controller, value]() mutable { ptr->processMidiEvent({ midievent::CONTROLCHANGE, channel, controller, value }); });
+        ptr->processMidiEvent({ midievent::CONTROLCHANGE, channel, controller, value });
     }
 
     static void instance_multi_programchange(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable { ptr->processMidiEvent({ midievent::PROGRAMCHANGE, channel, value, 0 }); });
+        ptr->processMidiEvent({ midievent::PROGRAMCHANGE, channel, value, 0 });
     }
 
     static void instance_multi_pitchbend(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable { ptr->processMidiEvent({ midievent::PITCHBEND, channel, value, 0 }); });
+        ptr->processMidiEvent({ midievent::PITCHBEND, channel, value, 0 });
     }
 
     static void instance_multi_aftertouch(pd::Instance* ptr, int channel, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, value]() mutable { ptr->processMidiEvent({ midievent::AFTERTOUCH, channel, value, 0 }); });
+        ptr->processMidiEvent({ midievent::AFTERTOUCH, channel, value, 0 });
     }
 
     static void instance_multi_polyaftertouch(pd::Instance* ptr, int channel, int pitch, int value)
     {
-        ptr->enqueueFunctionAsync([ptr, channel, pitch, value]() mutable { ptr->processMidiEvent({ midievent::POLYAFTERTOUCH, channel, pitch, value }); });
+        ptr->processMidiEvent({ midievent::POLYAFTERTOUCH, channel, pitch, value });
     }
 
     static void instance_multi_midibyte(pd::Instance* ptr, int port, int byte)
     {
-        ptr->enqueueFunctionAsync([ptr, port, byte]() mutable { ptr->processMidiEvent({ midievent::MIDIBYTE, port, byte, 0 }); });
+        ptr->processMidiEvent({ midievent::MIDIBYTE, port, byte, 0 });
     }
 
     static void instance_multi_print(pd::Instance* ptr, char const* s)
@@ -111,6 +102,7 @@ namespace pd {
 
 Instance::Instance(String const& symbol)
     : consoleHandler(this)
+    , messageDispatcher(this)
 {
     libpd_multi_init();
 
@@ -135,6 +127,8 @@ Instance::Instance(String const& symbol)
 
     m_atoms = malloc(sizeof(t_atom) * 512);
 
+    m_profiler = libpd_profiler_new();
+
     // Register callback when pd's gui changes
     // Needs to be done on pd's thread
     auto gui_trigger = [](void* instance, char const* name, t_atom* arg1, t_atom* arg2, t_atom* arg3) {
@@ -184,10 +178,14 @@ Instance::Instance(String const& symbol)
     register_gui_triggers(static_cast<t_pdinstance*>(m_instance), this, gui_trigger, message_trigger);
 
     setThis();
+
+    setSymbol = generateSymbol("set");
 }
 
 Instance::~Instance()
 {
+    messageDispatcher.stopTimer();
+
     pd_free(static_cast<t_pd*>(m_message_receiver));
     pd_free(static_cast<t_pd*>(m_midi_receiver));
     pd_free(static_cast<t_pd*>(m_print_receiver));
@@ -195,6 +193,8 @@ Instance::~Instance()
     pd_free(static_cast<t_pd*>(m_parameter_change_receiver));
 
     libpd_set_instance(static_cast<t_pdinstance*>(m_instance));
+    patchCache.clear();
+    libpd_profiler_free(static_cast<t_libpd_profiler*>(m_profiler));
     libpd_free_instance(static_cast<t_pdinstance*>(m_instance));
 }
 
@@ -257,10 +257,145 @@ void Instance::releaseDSP()
     libpd_message("pd", "dsp", 1, &av);
 }
 
-void Instance::performDSP(float const* inputs, float* outputs)
+void Instance::performDSP(float const* const* inputs, int numInputs, float* const* outputs, int numOutputs, int offset)
 {
     libpd_set_instance(static_cast<t_pdinstance*>(m_instance));
-    libpd_process_raw(inputs, outputs);
+
+    t_libpd_profiler* profiler = nullptr;
+    if (auto const interval = dspProfilingInterval.load(std::memory_order_relaxed); interval > 0 && --dspTicksUntilProfile <= 0) {
+        profiler = static_cast<t_libpd_profiler*>(m_profiler);
+        dspTicksUntilProfile = interval;
+    }
+
+    libpd_process_channels(inputs, numInputs, outputs, numOutputs, offset, profiler);
+}
+
+void Instance::setDSPProfilingInterval(int interval)
+{
+    dspProfilingInterval = std::max(interval, 0);
+}
+
+void Instance::updateDSPProfileObjects()
+{
+    dspProfileObjects.clear();
+    dspProfileNames.clear();
+
+    lockAudioThread();
+
+    auto* dspSymbol = gensym("dsp");
+
+    // Collects the memory range of every object, with the subpatch it lives in
+    // Returns whether the canvas contains anything that takes part in DSP
+    std::function<bool(t_canvas*, t_gobj*)> addObjects = [&](t_canvas* cnv, t_gobj* parent) {
+        bool hasDSP = false;
+        for (t_gobj* y = cnv->gl_list; y; y = y->g_next) {
+            if (!pd_checkobject(&y->g_pd))
+                continue;
+
+            auto* objectClass = pd_class(&y->g_pd);
+            auto const start = reinterpret_cast<t_int>(y);
+            dspProfileObjects.push_back({ start, start + static_cast<t_int>(objectClass->c_size), y, parent, class_getname(objectClass) });
+
+            auto const objectHasDSP = objectClass == canvas_class ? addObjects(reinterpret_cast<t_canvas*>(y), y) : zgetfn(&y->g_pd, dspSymbol) != nullptr;
+
+            // Only objects that can show up in the profile need their text, the others fall back to their class name
+            if (objectHasDSP) {
+                char* text = nullptr;
+                int size = 0;
+                libpd_get_object_text(y, &text, &size);
+
+                if (text && size)
+                    dspProfileNames[y] = String::fromUTF8(text, size);
+
+                freebytes(static_cast<void*>(text), static_cast<size_t>(size) * sizeof(char));
+            }
+
+            hasDSP = hasDSP || objectHasDSP;
+        }
+        return hasDSP;
+    };
+
+    for (t_canvas* cnv = pd_getcanvaslist(); cnv; cnv = cnv->gl_next) {
+        addObjects(cnv, nullptr);
+    }
+
+    unlockAudioThread();
+
+    std::sort(dspProfileObjects.begin(), dspProfileObjects.end(), [](auto const& a, auto const& b) { return a.start < b.start; });
+}
+
+std::vector<Instance::DSPProfileEntry> Instance::getDSPProfile(bool reset)
+{
+    auto* profiler = static_cast<t_libpd_profiler*>(m_profiler);
+    std::vector<t_libpd_profiler_entry> entries(1024);
+    unsigned int generation = 0;
+
+    setThis();
+
+    // The audio thread never allocates for the profiler, it skips profiling until we made room for the current chain
+    libpd_profiler_reserve(profiler);
+
+    // Only the raw results are copied while pd is locked, they get traced back to objects afterwards
+    auto numEntries = libpd_profiler_read(profiler, entries.data(), static_cast<int>(entries.size()), false, &generation);
+    if (numEntries > static_cast<int>(entries.size())) {
+        entries.resize(numEntries);
+    }
+    numEntries = libpd_profiler_read(profiler, entries.data(), static_cast<int>(entries.size()), reset, &generation);
+
+    // Objects can only be added to or removed from the chain by rebuilding it, so walking the patches again is only needed then
+    if (generation != dspProfileGeneration) {
+        updateDSPProfileObjects();
+        dspProfileGeneration = generation;
+    }
+
+    std::unordered_map<t_gobj*, DSPProfileObject const*> objects;
+    for (auto const& object : dspProfileObjects) {
+        objects[object.object] = &object;
+    }
+
+    auto findObject = [this](t_int address) -> t_gobj* {
+        auto it = std::upper_bound(dspProfileObjects.begin(), dspProfileObjects.end(), address, [](t_int value, auto const& range) { return value < range.start; });
+        if (it == dspProfileObjects.begin())
+            return nullptr;
+
+        --it;
+        return address < it->end ? it->object : nullptr;
+    };
+
+    std::unordered_map<t_gobj*, double> times;
+
+    for (int i = 0; i < numEntries; i++) {
+        auto const& entry = entries[i];
+
+        // Most perform routines get passed their object, or a struct that's part of it
+        // Routines that only get passed signal vectors, like the arithmetic ones, can't be attributed
+        t_gobj* object = nullptr;
+        for (int arg = 0; arg < entry.num_args && !object; arg++) {
+            object = findObject(entry.args[arg]);
+        }
+
+        times[object] += entry.time;
+
+        // Subpatches show the total for everything inside of them
+        for (auto* parent = object ? objects[object]->parent : nullptr; parent; parent = objects[parent]->parent) {
+            times[parent] += entry.time;
+        }
+    }
+
+    std::vector<DSPProfileEntry> result;
+    result.reserve(times.size());
+
+    for (auto const& [object, time] : times) {
+        if (!object) {
+            result.push_back({ nullptr, "unattributed", time });
+            continue;
+        }
+
+        auto name = dspProfileNames.find(object);
+        result.push_back({ object, name != dspProfileNames.end() ? name->second : String(objects[object]->className), time });
+    }
+
+    return result;
 }
 
 void Instance::sendNoteOn(int const channel, int const pitch, int const velocity) const
@@ -371,7 +506,33 @@ void Instance::sendList(char const* receiver, std::vector<Atom> const& list) con
 void Instance::sendMessage(void* object, char const* msg, std::vector<Atom> const& list) const
 {
     if(!object) return;
-    
+
+    sendTypedMessage(static_cast<t_pd*>(object), generateSymbol(msg), list);
+}
+
+void Instance::sendMessage(char const* receiver, char const* msg, std::vector<Atom> const& list) const
+{
+    sendMessage(generateSymbol(receiver)->s_thing, msg, list);
+}
+
+void Instance::sendFloat(SymbolHandle const& receiver, float const value) const
+{
+    setThis();
+
+    if (auto* object = receiver.getReceiver())
+        pd_float(object, value);
+}
+
+void Instance::sendMessage(SymbolHandle const& receiver, SymbolHandle const& selector, std::vector<Atom> const& list) const
+{
+    setThis();
+
+    if (auto* object = receiver.getReceiver())
+        sendTypedMessage(object, selector.get(), list);
+}
+
+void Instance::sendTypedMessage(t_pd* object, t_symbol* selector, std::vector<Atom> const& list) const
+{
     libpd_set_instance(static_cast<t_pdinstance*>(m_instance));
 
     auto* argv = static_cast<t_atom*>(m_atoms);
@@ -383,12 +544,7 @@ void Instance::sendMessage(void* object, char const* msg, std::vector<Atom> cons
             libpd_set_symbol(argv + i, list[i].getSymbol().toRawUTF8());
     }
 
-    pd_typedmess(static_cast<t_pd*>(object), generateSymbol(msg), static_cast<int>(list.size()), argv);
-}
-
-void Instance::sendMessage(char const* receiver, char const* msg, std::vector<Atom> const& list) const
-{
-    sendMessage(generateSymbol(receiver)->s_thing, msg, list);
+    pd_typedmess(object, selector, static_cast<int>(list.size()), argv);
 }
 
 void Instance::processMessage(Message mess)
@@ -449,41 +605,43 @@ void Instance::processMidiEvent(midievent event)
     }
 }
 
-void Instance::processSend(dmessage mess)
+void Instance::processCommand(Command& command)
 {
-    setThis();
-    
-    if (mess.object) {
-        if (mess.selector == "list") {
-            auto* argv = static_cast<t_atom*>(m_atoms);
-            for (size_t i = 0; i < mess.list.size(); ++i) {
-                if (mess.list[i].isFloat())
-                    SETFLOAT(argv + i, mess.list[i].getFloat());
-                else if (mess.list[i].isSymbol()) {
-                    sys_lock();
-                    SETSYMBOL(argv + i, generateSymbol(mess.list[i].getSymbol()));
-                    sys_unlock();
-                } else
-                    SETFLOAT(argv + i, 0.0);
-            }
-            sys_lock();
-            pd_list(static_cast<t_pd*>(mess.object), generateSymbol("list"), static_cast<int>(mess.list.size()), argv);
-            sys_unlock();
-        } else if (mess.selector == "float" && !mess.list.empty() && mess.list[0].isFloat()) {
-            sys_lock();
-            pd_float(static_cast<t_pd*>(mess.object), mess.list[0].getFloat());
-            sys_unlock();
-        } else if (mess.selector == "symbol" && !mess.list.empty() && mess.list[0].isSymbol()) {
-            sys_lock();
-            pd_symbol(static_cast<t_pd*>(mess.object), generateSymbol(mess.list[0].getSymbol()));
-            sys_unlock();
-        }
-        else {
-            sendMessage(static_cast<t_pd*>(mess.object), mess.selector.toRawUTF8(), mess.list);
-        }
-    } else {
-        sendMessage(mess.destination.toRawUTF8(), mess.selector.toRawUTF8(), mess.list);
+    if (command.type == Command::Function) {
+        command.function();
+        return;
     }
+
+    if (command.patch && command.patch->objectWasDeleted(command.object))
+        return;
+
+    auto* target = command.object ? static_cast<t_pd*>(command.object) : (command.destination ? command.destination->s_thing : nullptr);
+
+    if (!target)
+        return;
+
+    sys_lock();
+    switch (command.type) {
+    case Command::FloatToObject:
+        pd_float(target, atom_getfloat(command.atoms));
+        break;
+    case Command::SetFloatAndBang:
+        pd_typedmess(target, setSymbol, 1, command.atoms);
+        pd_bang(target);
+        break;
+    case Command::SymbolToObject:
+        pd_symbol(target, atom_getsymbol(command.atoms));
+        break;
+    case Command::ListToObject:
+        pd_list(target, &s_list, command.size, command.atoms);
+        break;
+    case Command::Message:
+        pd_typedmess(target, command.selector, command.size, command.atoms);
+        break;
+    default:
+        break;
+    }
+    sys_unlock();
 }
 
 void Instance::registerMessageListener(void* object, MessageListener* messageListener)
@@ -505,6 +663,67 @@ void Instance::unregisterMessageListener(void* object, MessageListener* messageL
         messageListeners[object].erase(it);
 }
 
+// The instance that the current thread is dequeuing commands for, if any
+static thread_local Instance* dequeuingInstance = nullptr;
+
+void Instance::enqueueCommand(Command&& command, bool notify)
+{
+    // Commands that are created by a callback while we are dequeuing can't be performed right away, the callback might hold the pd lock
+    // The dequeuing loop picks them up before it returns
+    m_command_queue.enqueue(std::move(command));
+
+    // Checks if it can be performed immediately
+    if (notify)
+        messageEnqueued();
+}
+
+t_symbol* Instance::getCommandSymbol(String const& name)
+{
+    {
+        ScopedLock lock(symbolCacheLock);
+        if (auto it = symbolCache.find(name); it != symbolCache.end())
+            return it->second;
+    }
+
+    // gensym isn't thread-safe, but we shouldn't wait for the audio tick here either
+    // The caller might also hold the pd lock already, which isn't recursive
+    if (sys_trylock() != 0)
+        return nullptr;
+
+    auto* symbol = generateSymbol(name);
+    sys_unlock();
+
+    ScopedLock lock(symbolCacheLock);
+
+    // Symbols that were dropped from the cache stay valid, they just need the lock again for the next lookup
+    if (symbolCache.size() >= maxCachedSymbols)
+        symbolCache.clear();
+
+    symbolCache.emplace(name, symbol);
+    return symbol;
+}
+
+bool Instance::toAtoms(std::vector<Atom> const& list, Command& command)
+{
+    if (list.size() > Command::maxAtoms)
+        return false;
+
+    // Symbols are resolved when the command is created, so the audio thread only receives interned symbols
+    // If a symbol can't be resolved without blocking, the caller falls back to a callback that resolves it in pd
+    for (int i = 0; i < list.size(); i++) {
+        if (list[i].isFloat()) {
+            SETFLOAT(command.atoms + i, list[i].getFloat());
+        } else if (auto* symbol = getCommandSymbol(list[i].getSymbol())) {
+            SETSYMBOL(command.atoms + i, symbol);
+        } else {
+            return false;
+        }
+    }
+
+    command.size = static_cast<int>(list.size());
+    return true;
+}
+
 void Instance::enqueueFunction(std::function<void(void)> const& fn)
 {
 
@@ -512,48 +731,121 @@ void Instance::enqueueFunction(std::function<void(void)> const& fn)
     if (isPerformingGlobalSync)
         return;
 
-    // This should be the way to do it, but it currently causes some issues
-    // By calling fn directly we fix these issues at the cost of possible thread unsafety
-    m_function_queue.enqueue(fn);
-
-    // Checks if it can be performed immediately
-    messageEnqueued();
+    Command command;
+    command.function = fn;
+    enqueueCommand(std::move(command));
 }
 
 void Instance::enqueueFunctionAsync(std::function<void(void)> const& fn)
 {
-    m_function_queue.enqueue(fn);
+    Command command;
+    command.function = fn;
+    enqueueCommand(std::move(command), false);
 }
 
 void Instance::enqueueMessages(String const& dest, String const& msg, std::vector<Atom>&& list)
 {
-    enqueueFunction([this, dest, msg, list]() mutable { processSend(dmessage { nullptr, dest, msg, std::move(list) }); });
+    if (isPerformingGlobalSync)
+        return;
+
+    Command command;
+    command.type = Command::Message;
+    command.destination = getCommandSymbol(dest);
+    command.selector = getCommandSymbol(msg);
+
+    if (!command.destination || !command.selector || !toAtoms(list, command)) {
+        enqueueFunction([this, dest, msg, list]() mutable { sendMessage(dest.toRawUTF8(), msg.toRawUTF8(), list); });
+        return;
+    }
+
+    enqueueCommand(std::move(command));
 }
 
 void Instance::enqueueDirectMessages(void* object, String const& msg, std::vector<Atom>&& list)
 {
-    enqueueFunction([this, object, msg, list]() mutable { processSend(dmessage { object, String(), msg, std::move(list) }); });
+    if (isPerformingGlobalSync)
+        return;
+
+    Command command;
+    command.type = Command::Message;
+    command.object = object;
+    command.selector = getCommandSymbol(msg);
+
+    if (!command.selector || !toAtoms(list, command)) {
+        enqueueFunction([this, object, msg, list]() mutable { sendMessage(object, msg.toRawUTF8(), list); });
+        return;
+    }
+
+    enqueueCommand(std::move(command));
 }
 
 void Instance::enqueueDirectMessages(void* object, std::vector<Atom> const&& list)
 {
-    enqueueFunction([this, object, list]() mutable { processSend(dmessage { object, String(), "list", std::move(list) }); });
+    if (isPerformingGlobalSync)
+        return;
+
+    Command command;
+    if (!toAtoms(list, command)) {
+        enqueueFunction([this, object, list]() mutable { sendMessage(object, "list", list); });
+        return;
+    }
+
+    command.type = Command::ListToObject;
+    command.object = object;
+    enqueueCommand(std::move(command));
 }
 
 void Instance::enqueueDirectMessages(void* object, String const& msg)
 {
-    enqueueFunction([this, object, msg]() mutable { processSend(dmessage { object, String(), "symbol", std::vector<Atom>(1, msg) }); });
+    if (isPerformingGlobalSync)
+        return;
+
+    auto* symbol = getCommandSymbol(msg);
+    if (!symbol) {
+        enqueueFunction([this, object, msg]() { sendMessage(object, "symbol", std::vector<Atom>(1, msg)); });
+        return;
+    }
+
+    Command command;
+    command.type = Command::SymbolToObject;
+    command.object = object;
+    command.size = 1;
+    SETSYMBOL(command.atoms, symbol);
+
+    enqueueCommand(std::move(command));
 }
 
 void Instance::enqueueDirectMessages(void* object, float const msg)
 {
-    enqueueFunction([this, object, msg]() mutable { processSend(dmessage { object, String(), "float", std::vector<Atom>(1, msg) }); });
+    if (isPerformingGlobalSync)
+        return;
+
+    Command command;
+    command.type = Command::FloatToObject;
+    command.object = object;
+    command.size = 1;
+    SETFLOAT(command.atoms, msg);
+    enqueueCommand(std::move(command));
+}
+
+void Instance::enqueueFloatValue(void* object, float const value, Patch* patch)
+{
+    if (isPerformingGlobalSync)
+        return;
+
+    Command command;
+    command.type = Command::SetFloatAndBang;
+    command.object = object;
+    command.patch = patch;
+    command.size = 1;
+    SETFLOAT(command.atoms, value);
+    enqueueCommand(std::move(command));
 }
 
 void Instance::waitForStateUpdate()
 {
     // No action needed
-    if (m_function_queue.size_approx() == 0) {
+    if (m_command_queue.size_approx() == 0) {
         return;
     }
 
@@ -579,10 +871,51 @@ void Instance::sendMessagesFromQueue()
 {
     libpd_set_instance(static_cast<t_pdinstance*>(m_instance));
 
-    std::function<void(void)> callback;
-    while (m_function_queue.try_dequeue(callback)) {
-        callback();
+    // Callbacks can end up here again, those commands will be picked up by the loop below
+    if (dequeuingInstance == this)
+        return;
+
+    auto* const previousInstance = dequeuingInstance;
+    dequeuingInstance = this;
+
+    std::array<Command, commandBatchSize> commandBatch;
+    std::array<std::pair<void*, Command::Type>, commandBatchSize> coalescedObjects; // Object with the type of float command that it's coalescing
+
+    size_t numCommands;
+    while ((numCommands = m_command_queue.try_dequeue_bulk(commandBatch.begin(), commandBatch.size())) > 0) {
+
+        // Walk backwards so only the last float sent to an object within this batch gets through
+        // Any other command to that object, including the other kind of float command, or any callback, breaks the chain so ordering is preserved
+        auto coalescedEnd = coalescedObjects.begin();
+        for (int i = static_cast<int>(numCommands) - 1; i >= 0; i--) {
+            auto& command = commandBatch[i];
+
+            if (command.type == Command::FloatToObject || command.type == Command::SetFloatAndBang) {
+                auto it = std::find_if(coalescedObjects.begin(), coalescedEnd, [&command](auto const& key) { return key.first == command.object; });
+                if (it == coalescedEnd) {
+                    *coalescedEnd++ = { command.object, command.type };
+                } else if (it->second == command.type) {
+                    command.superseded = true;
+                } else {
+                    it->second = command.type;
+                }
+            } else if (command.type == Command::Function) {
+                coalescedEnd = coalescedObjects.begin();
+            } else {
+                coalescedEnd = std::remove_if(coalescedObjects.begin(), coalescedEnd, [&command](auto const& key) { return key.first == command.object; });
+            }
+        }
+
+        for (int i = 0; i < numCommands; i++) {
+            auto& command = commandBatch[i];
+            if (!command.superseded)
+                processCommand(command);
+
+            command = Command();
+        }
     }
+
+    dequeuingInstance = previousInstance;
 }
 
 String Instance::getExtraInfo(File const& toOpen)
@@ -605,9 +938,19 @@ Patch* Instance::openPatch(File const& toOpen)
     String filename = toOpen.getFileName();
     auto const* file = filename.toRawUTF8();
 
+    // Reading and hashing the file doesn't need the lock, and was usually done by the loader thread already
+    auto content = patchCache.getContent(toOpen);
+
     setThis();
 
-    cnv = static_cast<t_canvas*>(libpd_create_canvas(file, dir));
+    if (content) {
+        sys_lock();
+        cnv = static_cast<t_canvas*>(libpd_create_canvas_from_binbuf(patchCache.getBinbuf(*content), file, dir));
+        sys_unlock();
+    } else {
+        // Let pd deal with files that we can't read ourselves, it will also report the error
+        cnv = static_cast<t_canvas*>(libpd_create_canvas(file, dir));
+    }
 
     return new Patch(cnv, this, true, toOpen);
 }
@@ -628,6 +971,11 @@ t_symbol* Instance::generateSymbol(String const& symbol) const
     return generateSymbol(symbol.toRawUTF8());
 }
 
+SymbolHandle Instance::generateSymbolHandle(char const* symbol) const
+{
+    return SymbolHandle(generateSymbol(symbol));
+}
+
 void Instance::logMessage(String const& message)
 {
     consoleHandler.logMessage(message);
@@ -16,6 +16,7 @@ extern "C" {
 #include <concurrentqueue.h>
 
 #include "PdPatch.h"
+#include "PdPatchCache.h"
 #include "../Utility/StringUtils.h"
 
 namespace pd {
@@ -116,6 +117,32 @@ private:
     String symbol;
 };
 
+// A symbol that's resolved once, so sending to it doesn't need a string conversion and gensym lookup every time
+// Pd never frees symbols and the receiver is only looked up when sending, so a handle stays valid when bindings change
+class SymbolHandle {
+public:
+    SymbolHandle() = default;
+
+    explicit SymbolHandle(t_symbol* sym)
+        : symbol(sym)
+    {
+    }
+
+    t_symbol* get() const
+    {
+        return symbol;
+    }
+
+    // Whatever is bound to the symbol right now, nullptr if there are no receivers
+    t_pd* getReceiver() const
+    {
+        return symbol ? symbol->s_thing : nullptr;
+    }
+
+private:
+    t_symbol* symbol = nullptr;
+};
+
 struct MessageListener {
     virtual void receiveMessage(String const& name, int argc, t_atom* argv) {};
 
@@ -129,11 +156,29 @@ class Instance {
         std::vector<pd::Atom> list;
     };
 
-    struct dmessage {
-        void* object;
-        String destination;
-        String selector;
-        std::vector<pd::Atom> list;
+    // A single action from the GUI to pd
+    // Common object interactions are stored inline, anything else falls back to a callback
+    struct Command {
+        enum Type {
+            Function,
+            FloatToObject,
+            SetFloatAndBang,
+            SymbolToObject,
+            ListToObject,
+            Message
+        };
+
+        static constexpr int maxAtoms = 8;
+
+        Type type = Function;
+        void* object = nullptr;
+        t_symbol* destination = nullptr;
+        t_symbol* selector = nullptr;
+        Patch* patch = nullptr; // If set, the command is dropped when the object was deleted from this patch
+        int size = 0;
+        t_atom atoms[maxAtoms];
+        std::function<void(void)> function;
+        bool superseded = false;
     };
 
     typedef struct midievent {
@@ -152,6 +197,12 @@ class Instance {
     } midievent;
 
 public:
+    struct DSPProfileEntry {
+        void* object;
+        String text;
+        double time;
+    };
+
     Instance(String const& symbol);
     Instance(Instance const& other) = delete;
     virtual ~Instance();
@@ -160,9 +211,16 @@ public:
     void prepareDSP(int const nins, int const nouts, double const samplerate, int const blockSize);
     void startDSP();
     void releaseDSP();
-    void performDSP(float const* inputs, float* outputs);
+    // Runs a single Pd tick of getBlockSize() samples, starting at offset in each channel
+    void performDSP(float const* const* inputs, int numInputs, float* const* outputs, int numOutputs, int offset);
     int getBlockSize() const;
 
+    // Times the perform routine of every object on one out of every interval DSP ticks, 0 turns the profiler off
+    void setDSPProfilingInterval(int interval);
+    // Average time per tick in seconds for every object that was profiled, subpatches include the time of their contents
+    // Time that couldn't be traced back to an object is stored in an entry without object
+    std::vector<DSPProfileEntry> getDSPProfile(bool reset = true);
+
     void sendNoteOn(int const channel, int const pitch, int const velocity) const;
     void sendControlChange(int const channel, int const controller, int const value) const;
     void sendProgramChange(int const channel, int const value) const;
@@ -205,6 +263,10 @@ public:
     void sendList(char const* receiver, std::vector<pd::Atom> const& list) const;
     void sendMessage(char const* receiver, char const* msg, std::vector<pd::Atom> const& list) const;
     void sendMessage(void* object, char const* msg, std::vector<Atom> const& list) const;
+
+    // Allocation and lookup free variants for the audio thread
+    void sendFloat(SymbolHandle const& receiver, float const value) const;
+    void sendMessage(SymbolHandle const& receiver, SymbolHandle const& selector, std::vector<Atom> const& list) const;
     
     virtual void receivePrint(String const& message) {};
 
@@ -242,6 +304,7 @@ public:
     void enqueueDirectMessages(void* object, std::vector<pd::Atom> const&& list);
     void enqueueDirectMessages(void* object, String const& msg);
     void enqueueDirectMessages(void* object, float const msg);
+    void enqueueFloatValue(void* object, float const value, Patch* patch);
 
     virtual void performParameterChange(int type, String name, float value) {};
 
@@ -257,7 +320,7 @@ public:
     void sendMessagesFromQueue();
     void processMessage(Message mess);
     void processMidiEvent(midievent event);
-    void processSend(dmessage mess);
+    void processCommand(Command& command);
 
     String getExtraInfo(File const& toOpen);
     Patch* openPatch(File const& toOpen);
@@ -272,6 +335,7 @@ public:
     void setThis() const;
     t_symbol* generateSymbol(String const& symbol) const;
     t_symbol* generateSymbol(const char* symbol) const;
+    SymbolHandle generateSymbolHandle(char const* symbol) const;
     
 
     void waitForStateUpdate();
@@ -292,6 +356,7 @@ public:
     void* m_parameter_change_receiver = nullptr;
     void* m_midi_receiver = nullptr;
     void* m_print_receiver = nullptr;
+    void* m_profiler = nullptr;
 
     std::atomic<bool> canUndo = false;
     std::atomic<bool> canRedo = false;
@@ -300,6 +365,8 @@ public:
     inline static const String defaultPatch = "#N canvas 827 239 527 327 12;";
 
     bool isPerformingGlobalSync = false;
+
+    PatchCache patchCache;
     CriticalSection const* audioLock;
 
 private:
@@ -308,13 +375,50 @@ private:
     
     std::unordered_map<void*, std::vector<WeakReference<MessageListener>>> messageListeners;
 
-    moodycamel::ConcurrentQueue<std::function<void(void)>> m_function_queue = moodycamel::ConcurrentQueue<std::function<void(void)>>(4096);
+    void sendTypedMessage(t_pd* object, t_symbol* selector, std::vector<Atom> const& list) const;
+
+    void enqueueCommand(Command&& command, bool notify = true);
+    bool toAtoms(std::vector<Atom> const& list, Command& command);
+
+    // Interns a symbol for a command without blocking on the pd lock, returns nullptr if the lock is busy
+    // Pd never frees symbols, so every symbol we looked up once is kept here and needs no lock after that
+    t_symbol* getCommandSymbol(String const& name);
+
+    moodycamel::ConcurrentQueue<Command> m_command_queue = moodycamel::ConcurrentQueue<Command>(4096);
+
+    // Commands are dequeued in batches, so repeated float values to the same object can be coalesced
+    // The batch lives on the stack of whoever is dequeuing, the audio thread and the message thread can both do that
+    static constexpr int commandBatchSize = 32;
+
+    t_symbol* setSymbol = nullptr;
+
+    CriticalSection symbolCacheLock;
+    std::map<String, t_symbol*> symbolCache;
+    static constexpr size_t maxCachedSymbols = 4096;
 
     std::unique_ptr<FileChooser> saveChooser;
     std::unique_ptr<FileChooser> openChooser;
 
     std::atomic<int> numLocksHeld = 0;
 
+    std::atomic<int> dspProfilingInterval = 0;
+    int dspTicksUntilProfile = 0; // Only touched by the audio thread
+
+    // Objects that the profiled DSP chain can point into, only collected again when the chain changes
+    struct DSPProfileObject {
+        t_int start;
+        t_int end;
+        t_gobj* object;
+        t_gobj* parent;
+        char const* className;
+    };
+
+    void updateDSPProfileObjects();
+
+    std::vector<DSPProfileObject> dspProfileObjects; // Sorted by address
+    std::unordered_map<t_gobj*, String> dspProfileNames;
+    unsigned int dspProfileGeneration = 0;
+
     WaitableEvent updateWait;
 
 protected:
@@ -428,5 +532,89 @@ protected:
     };
 
     ConsoleHandler consoleHandler;
+
+    // Carries messages from the "pd", "param" and "param_change" receivers to the message thread
+    // Records are preallocated and only hold interned symbols and plain atoms, so enqueueing never allocates on the audio thread
+    struct MessageDispatcher : public Timer {
+        static constexpr int maxAtoms = 32;
+        static constexpr int capacity = 1024;
+
+        struct MessageRecord {
+            t_symbol* destination;
+            t_symbol* selector;
+            int size;
+            t_atom atoms[maxAtoms];
+        };
+
+        Instance* instance;
+
+        MessageDispatcher(Instance* parent)
+            : instance(parent)
+            , fifo(capacity)
+            , records(capacity)
+        {
+            startTimer(10);
+        }
+
+        // Called from whichever thread is running pd, which is serialised by the audio callback lock
+        void enqueue(t_symbol* destination, t_symbol* selector, int argc, t_atom* argv)
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+            if (size1 + size2 < 1) {
+                numDropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            if (argc > maxAtoms) {
+                numTruncated.fetch_add(1, std::memory_order_relaxed);
+                argc = maxAtoms;
+            }
+
+            auto& record = records[size1 > 0 ? start1 : start2];
+            record.destination = destination;
+            record.selector = selector;
+            record.size = argc;
+            std::copy(argv, argv + argc, record.atoms);
+
+            fifo.finishedWrite(1);
+        }
+
+        // Drains everything that is currently in the queue in one pass
+        void timerCallback() override
+        {
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+            for (int i = start1; i < start1 + size1; i++)
+                dispatch(records[i]);
+
+            for (int i = start2; i < start2 + size2; i++)
+                dispatch(records[i]);
+
+            fifo.finishedRead(size1 + size2);
+
+            if (auto dropped = numDropped.exchange(0)) {
+                instance->logWarning("Message queue overflow: dropped " + String(dropped) + " messages from pd");
+            }
+            if (auto truncated = numTruncated.exchange(0)) {
+                instance->logWarning("Truncated " + String(truncated) + " messages from pd to " + String(maxAtoms) + " atoms");
+            }
+        }
+
+        void dispatch(MessageRecord const& record)
+        {
+            instance->processMessage({ String::fromUTF8(record.selector->s_name), String::fromUTF8(record.destination->s_name), Atom::fromAtoms(record.size, const_cast<t_atom*>(record.atoms)) });
+        }
+
+        AbstractFifo fifo;
+        std::vector<MessageRecord> records;
+
+        std::atomic<int> numDropped = 0;
+        std::atomic<int> numTruncated = 0;
+    };
+
+    MessageDispatcher messageDispatcher;
 };
 } // namespace pd
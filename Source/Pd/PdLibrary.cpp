@@ -12,6 +12,7 @@ extern "C" {
 #include <z_libpd.h>
 }
 
+#include <queue>
 #include <utility>
 #include <vector>
 
@@ -27,180 +28,151 @@ struct _canvasenvironment {
 
 namespace pd {
 
-// Iterative function to insert a key into a Trie
-void Trie::insert(String key)
+RadixTree::RadixTree(std::vector<Entry> entries)
 {
     // Names with spaces not supported yet by the suggestor
-    if (key.containsChar(' '))
-        key = key.upToFirstOccurrenceOf(" ", false, false);
-
-    // start from the root node
-    Trie* curr = this;
-    for (char i : key) {
-        if (!curr)
-            continue;
-
-        // create a new node if the path doesn't exist
-        if (curr->character[i] == nullptr) {
-            curr->character[i] = new Trie();
-        }
-
-        // go to the next node
-        curr = curr->character[i];
+    std::vector<std::pair<std::string, int>> sorted;
+    sorted.reserve(entries.size());
+    for (auto& [name, weight] : entries) {
+        auto key = name.upToFirstOccurrenceOf(" ", false, false);
+        if (key.isNotEmpty())
+            sorted.emplace_back(key.toStdString(), weight);
     }
 
-    // mark the current node as a leaf
-    curr->isLeaf = true;
-}
-
-// Iterative function to search a key in a Trie. It returns true
-// if the key is found in the Trie; otherwise, it returns false
-bool Trie::search(String const& key)
-{
-    Trie* curr = this;
-    for (char i : key) {
-        // go to the next node
-        curr = curr->character[i];
-
-        // if the string is invalid (reached end of a path in the Trie)
-        if (curr == nullptr) {
-            return false;
-        }
-    }
+    // Sort by name, and only keep the highest weight for names that were added more than once
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) {
+        return a.first != b.first ? a.first < b.first : a.second > b.second;
+    });
+    sorted.erase(std::unique(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.first == b.first; }), sorted.end());
 
-    // return true if the current node is a leaf and the
-    // end of the string is reached
-    return curr->isLeaf;
-}
+    if (sorted.empty())
+        return;
 
-// Returns true if a given node has any children
-bool Trie::hasChildren()
-{
-    for (auto& i : character) {
-        if (i) {
-            return true; // child found
-        }
+    std::vector<uint32> nameOffsets;
+    nameOffsets.reserve(sorted.size());
+    for (auto const& [name, weight] : sorted) {
+        nameOffsets.push_back(static_cast<uint32>(names.size()));
+        names += name;
     }
 
-    return false;
+    numNames = sorted.size();
+    build(sorted, 0, sorted.size(), 0, 0, nameOffsets);
 }
 
-// Recursive function to delete a key in the Trie
-bool Trie::deletion(Trie*& curr, String key)
+uint32 RadixTree::build(std::vector<std::pair<std::string, int>> const& sorted, size_t begin, size_t end, size_t parentDepth, size_t depth, std::vector<uint32> const& nameOffsets)
 {
-    // return if Trie is empty
-    if (curr == nullptr) {
-        return false;
+    auto const index = static_cast<uint32>(nodes.size());
+    nodes.push_back({ static_cast<uint32>(nameOffsets[begin] + parentDepth), static_cast<uint32>(depth - parentDepth), 0, 0, 0, 0, -1, -1 });
+
+    // The names are sorted, so if a name ends at this node, it's the first one
+    if (sorted[begin].first.size() == depth) {
+        nodes[index].nameStart = nameOffsets[begin];
+        nodes[index].nameLength = static_cast<uint32>(depth);
+        nodes[index].weight = sorted[begin].second;
+        begin++;
     }
 
-    // if the end of the key is not reached
-    if (key.length()) {
-        // recur for the node corresponding to the next character in the key
-        // and if it returns true, delete the current node (if it is non-leaf)
-
-        if (curr != nullptr && curr->character[key[0]] != nullptr && deletion(curr->character[key[0]], key.substring(1)) && !curr->isLeaf) {
-            if (!curr->hasChildren()) {
-                delete curr;
-                curr = nullptr;
-                return true;
-            }
-
-            return false;
-        }
+    std::vector<uint32> childIndices;
+    while (begin < end) {
+        auto const character = sorted[begin].first[depth];
+        auto groupEnd = begin + 1;
+        while (groupEnd < end && sorted[groupEnd].first[depth] == character)
+            groupEnd++;
+
+        // In a sorted range, the common prefix of the first and last name is the common prefix of all of them
+        auto const& first = sorted[begin].first;
+        auto const& last = sorted[groupEnd - 1].first;
+        auto commonLength = depth + 1;
+        while (commonLength < first.size() && commonLength < last.size() && first[commonLength] == last[commonLength])
+            commonLength++;
+
+        childIndices.push_back(build(sorted, begin, groupEnd, depth, commonLength, nameOffsets));
+        begin = groupEnd;
     }
 
-    // if the end of the key is reached
-    if (key.length() == 0 && curr->isLeaf) {
-        // if the current node is a leaf node and doesn't have any children
-        if (!curr->hasChildren()) {
-            // delete the current node
-            delete curr;
-            curr = nullptr;
-
-            // delete the non-leaf parent nodes
-            return true;
-        }
-
-        // mark the current node as a non-leaf node (DON'T DELETE IT)
-        curr->isLeaf = false;
-
-        // don't delete its parent nodes
-        return false;
+    auto& node = nodes[index];
+    node.firstChild = static_cast<uint32>(children.size());
+    node.numChildren = static_cast<uint32>(childIndices.size());
+    node.bestWeight = node.weight;
+    for (auto child : childIndices) {
+        node.bestWeight = std::max(node.bestWeight, nodes[child].bestWeight);
     }
 
-    return false;
+    children.insert(children.end(), childIndices.begin(), childIndices.end());
+
+    return index;
 }
 
-void Trie::suggestionsRec(String currPrefix, Suggestions& result)
+Suggestions RadixTree::autocomplete(String const& query, int maxResults) const
 {
-    // found aString in Trie with the given prefix
-    if (isLeaf) {
-        result.add(currPrefix);
-    }
+    Suggestions result;
+    if (nodes.empty())
+        return result;
 
-    // All children struct node pointers are nullptr
-    if (!hasChildren())
-        return;
+    // Find the node where the query ends, which might be halfway through its label
+    auto const key = query.toStdString();
+    uint32 current = 0;
+    size_t matched = 0;
+    while (matched < key.size()) {
+        auto const& node = nodes[current];
+        auto const* firstChild = children.data() + node.firstChild;
+        auto const* lastChild = firstChild + node.numChildren;
+
+        auto const* child = std::lower_bound(firstChild, lastChild, key[matched], [this](uint32 child, char character) {
+            return static_cast<unsigned char>(names[nodes[child].labelStart]) < static_cast<unsigned char>(character);
+        });
 
-    for (int i = 0; i < CHAR_SIZE; i++) {
-        if (character[i]) {
-            // append current character to currPrefixString
-            // currPrefix += i;
-            char letter = INDEX_TO_CHAR(i);
-            currPrefix += String(&letter, 1);
+        if (child == lastChild || names[nodes[*child].labelStart] != key[matched])
+            return result;
 
-            // recur over the rest
-            character[i]->suggestionsRec(currPrefix, result);
+        auto const length = std::min<size_t>(nodes[*child].labelLength, key.size() - matched);
+        if (names.compare(nodes[*child].labelStart, length, key, matched, length) != 0)
+            return result;
 
-            // remove last character
-            currPrefix = currPrefix.dropLastCharacters(1);
-        }
+        matched += length;
+        current = *child;
     }
-}
-
-// print suggestions for given query prefix.
-int Trie::autocomplete(String query, Suggestions& result)
-{
-    auto* pCrawl = this;
 
-    // Check if prefix is present and find the
-    // the node (of last level) with last character
-    // of givenString.
-    int level;
-    int n = query.length();
-    for (level = 0; level < n; level++) {
-        int index = CHAR_TO_INDEX(query[level]);
+    // Best first search: subtrees are visited in order of the highest weight they contain
+    // Nodes are numbered in alphabetical order, which breaks ties between equal weights
+    struct Candidate {
+        int weight;
+        uint32 node;
+        bool isName;
+
+        bool operator<(Candidate const& other) const
+        {
+            if (weight != other.weight)
+                return weight < other.weight;
+            if (node != other.node)
+                return node > other.node;
+            return !isName && other.isName;
+        }
+    };
 
-        // no String in the Trie has this prefix
-        if (index < 0 || index >= 127 || !pCrawl->character[index])
-            return 0;
+    std::priority_queue<Candidate> candidates;
+    candidates.push({ nodes[current].bestWeight, current, false });
 
-        pCrawl = pCrawl->character[index];
-    }
+    while (!candidates.empty() && result.size() < maxResults) {
+        auto const candidate = candidates.top();
+        candidates.pop();
 
-    // If prefix is present as a word.
-    bool isWord = pCrawl->isLeaf;
+        auto const& node = nodes[candidate.node];
+        if (candidate.isName) {
+            result.add(String::fromUTF8(names.data() + node.nameStart, static_cast<int>(node.nameLength)));
+            continue;
+        }
 
-    // If prefix is last node of tree (has no
-    // children)
-    bool isLast = !pCrawl->hasChildren();
+        if (node.weight >= 0)
+            candidates.push({ node.weight, candidate.node, true });
 
-    // If prefix is present as a word, but
-    // there is no subtree below the last
-    // matching node.
-    if (isWord && isLast) {
-        result.add(query);
-        return -1;
+        for (uint32 i = 0; i < node.numChildren; i++) {
+            auto const child = children[node.firstChild + i];
+            candidates.push({ nodes[child].bestWeight, child, false });
+        }
     }
 
-    // If there are are nodes below last
-    // matching character.
-    if (!isLast) {
-        String const& prefix = query;
-        pCrawl->suggestionsRec(prefix, result);
-        return 1;
-    }
-    return 0;
+    return result;
 }
 
 void Library::initialiseLibrary()
@@ -218,7 +190,28 @@ void Library::initialiseLibrary()
         auto pddocPath = appDataDir.getChildFile("Library").getChildFile("Documentation").getChildFile("pddp").getFullPathName();
 
         updateLibrary();
-        parseDocumentation(pddocPath);
+
+        // Documentation only changes when the library gets unpacked again, so the version and the time of unpacking are enough to tell if the index is still valid
+        // The first instance to start after that parses the markdown files, all other instances just map the index
+        auto const fingerprint = String(PLUGDATA_VERSION) + " " + String(File(pddocPath).getLastModificationTime().toMilliseconds());
+        auto indexFile = appDataDir.getChildFile(".documentation_index");
+
+        auto newDocumentation = std::make_shared<DocumentationIndex>();
+        if (!newDocumentation->load(indexFile, fingerprint)) {
+            auto const parsed = parseDocumentation(pddocPath);
+
+            // If we can't write to the app data directory, still write it somewhere so we can map it
+            if (!DocumentationIndex::write(indexFile, fingerprint, parsed) || !newDocumentation->load(indexFile, fingerprint)) {
+                indexFile = File::getSpecialLocation(File::tempDirectory).getChildFile("plugdata_documentation_index");
+                DocumentationIndex::write(indexFile, fingerprint, parsed);
+                newDocumentation->load(indexFile, fingerprint);
+            }
+        }
+
+        {
+            SpinLock::ScopedLockType lock(documentationLock);
+            documentation = std::move(newDocumentation);
+        }
 
         // Paths to search
         // First, only search vanilla, then search all documentation
@@ -249,7 +242,12 @@ void Library::updateLibrary()
 
         auto pathTree = settingsTree.getChildWithName("Paths");
 
-        searchTree = std::make_unique<Trie>();
+        // Compiled objects come before abstractions with a similar name
+        static constexpr int objectWeight = 2;
+        static constexpr int abstractionWeight = 1;
+
+        std::vector<RadixTree::Entry> entries;
+        StringArray objects;
 
         // Get available objects directly from pd
         int i;
@@ -263,26 +261,24 @@ void Library::updateLibrary()
         mlist = o->c_methods;
 #endif
 
-        allObjects.clear();
-
         for (i = o->c_nmethod, m = mlist; i--; m++) {
 
             auto newName = String(m->me_name->s_name);
             if (!(newName.startsWith("else/") || newName.startsWith("cyclone/"))) {
-                allObjects.add(newName);
-                searchTree->insert(m->me_name->s_name);
+                objects.add(newName);
+                entries.push_back({ newName, objectWeight });
             }
         }
 
-        searchTree->insert("graph");
+        entries.push_back({ "graph", objectWeight });
 
         for (auto& path : defaultPaths) {
             for (const auto& iter : RangedDirectoryIterator(path, false)) {
                 auto file = iter.getFile();
                 // Get pd files but not help files
                 if (file.getFileExtension() == ".pd" && !(file.getFileNameWithoutExtension().startsWith("help-") || file.getFileNameWithoutExtension().endsWith("-help"))) {
-                    searchTree->insert(file.getFileNameWithoutExtension().toStdString());
-                    allObjects.add(file.getFileNameWithoutExtension().toStdString());
+                    entries.push_back({ file.getFileNameWithoutExtension(), abstractionWeight });
+                    objects.add(file.getFileNameWithoutExtension());
                 }
             }
         }
@@ -295,18 +291,47 @@ void Library::updateLibrary()
                 auto file = iter.getFile();
                 // Get pd files but not help files
                 if (file.getFileExtension() == ".pd" && !(file.getFileNameWithoutExtension().startsWith("help-") || file.getFileNameWithoutExtension().endsWith("-help"))) {
-                    searchTree->insert(file.getFileNameWithoutExtension().toStdString());
-                    allObjects.add(file.getFileNameWithoutExtension().toStdString());
+                    entries.push_back({ file.getFileNameWithoutExtension(), abstractionWeight });
+                    objects.add(file.getFileNameWithoutExtension());
                 }
             }
         }
+
+        // Everything is built on this thread, suggestions keep using the old tree until we swap in the new one
+        auto newSearchTree = std::make_shared<RadixTree const>(std::move(entries));
+
+        // The search index needs the documentation, which is always loaded by now, because it happens on this same thread
+        std::vector<SearchIndex::Document> documents;
+        auto const currentDocumentation = getDocumentation();
+        auto documentedObjects = currentDocumentation->getObjectNames();
+        documentedObjects.mergeArray(objects);
+        for (auto const& name : documentedObjects) {
+            // Whitespace is not supported by our autocompletion, because normally it indicates the start of the arguments
+            if (name.contains(" "))
+                continue;
+
+            SearchIndex::Document document { name, currentDocumentation->getDescription(name), objectKeywords.count(name) ? objectKeywords[name] : StringArray(), {} };
+            for (auto const& iolets : currentDocumentation->getIoletDescriptions(name)) {
+                for (auto const& [description, repeating] : iolets)
+                    document.ioletDescriptions.add(description);
+            }
+            documents.push_back(std::move(document));
+        }
+
+        searchIndex = std::make_unique<SearchIndex>(documents);
+
+        SpinLock::ScopedLockType lock(searchTreeLock);
+        searchTree = std::move(newSearchTree);
+        allObjects = std::move(objects);
     };
 
     libraryUpdateThread.addJob(updateFn);
 }
 
-void Library::parseDocumentation(String const& path)
+DocumentationIndex::Documentation Library::parseDocumentation(String const& path)
 {
+    DocumentationIndex::Documentation documentation;
+
     // Function to get sections from a text file based on a section name
     // Let it know which sections exists, and it will order them and put them in a map by name
     auto getSections = [](String contents, StringArray sectionNames) {
@@ -379,7 +404,7 @@ void Library::parseDocumentation(String const& path)
         return lines;
     };
 
-    auto parseFile = [this, getSections, formatText, sectionsFromHyphens](File& f) {
+    auto parseFile = [&documentation, getSections, formatText, sectionsFromHyphens](File& f) {
         String contents = f.loadFileAsString();
         auto sections = getSections(contents, { "\ntitle", "\ndescription", "\npdcategory", "\ncategories", "\nflags", "\narguments", "\nlast_update", "\ninlets", "\noutlets", "\ndraft", "\nsee_also", "\nmethods" });
 
@@ -392,7 +417,7 @@ void Library::parseDocumentation(String const& path)
             name = name.trim();
 
             if (sections.count("description")) {
-                objectDescriptions[name] = sections["description"].first;
+                documentation.descriptions[name] = sections["description"].first;
             }
             if (sections.count("methods")) {
 
@@ -402,7 +427,7 @@ void Library::parseDocumentation(String const& path)
                     methodList.push_back({ sectionMap["type"].first, sectionMap["description"].first });
                 }
 
-                methods[name] = methodList;
+                documentation.methods[name] = methodList;
             }
 
             if (sections.count("pdcategory")) {
@@ -410,7 +435,7 @@ void Library::parseDocumentation(String const& path)
                 if (categories.isEmpty())
                     categories = "Unknown";
                 for (auto category : StringArray::fromTokens(categories, ",", "")) {
-                    objectCategories[category.trim()].add(name);
+                    documentation.categories[category.trim()].add(name);
                 }
             }
 
@@ -427,13 +452,13 @@ void Library::parseDocumentation(String const& path)
                     args.push_back({ sectionMap["name"].first, sectionMap["description"].first, "" });
                 }
 
-                arguments[name] = args;
+                documentation.arguments[name] = args;
             }
 
             auto numbers = { "1st", "2nd", "3rd", "4th", "5th", "6th", "7th", "8th", "nth" };
             if (sections.count("inlets")) {
                 auto section = getSections(sections["inlets"].first, numbers);
-                ioletDescriptions[name][0].resize(static_cast<int>(section.size()));
+                documentation.iolets[name][0].resize(static_cast<int>(section.size()));
                 for (auto [number, content] : section) {
                     String tooltip;
                     for (auto& argument : sectionsFromHyphens(content.first)) {
@@ -444,12 +469,12 @@ void Library::parseDocumentation(String const& path)
                         tooltip += "(" + sectionMap["type"].first + ") " + sectionMap["description"].first + "\n";
                     }
 
-                    ioletDescriptions[name][0].getReference(content.second) = { tooltip, number == "nth" };
+                    documentation.iolets[name][0].getReference(content.second) = { tooltip, number == "nth" };
                 }
             }
             if (sections.count("outlets")) {
                 auto section = getSections(sections["outlets"].first, numbers);
-                ioletDescriptions[name][1].resize(static_cast<int>(section.size()));
+                documentation.iolets[name][1].resize(static_cast<int>(section.size()));
                 for (auto [number, content] : section) {
                     String tooltip;
 
@@ -460,7 +485,7 @@ void Library::parseDocumentation(String const& path)
                         tooltip += "(" + sectionMap["type"].first + ") " + sectionMap["description"].first + "\n";
                     }
 
-                    ioletDescriptions[name][1].getReference(content.second) = { tooltip, number == "nth" };
+                    documentation.iolets[name][1].getReference(content.second) = { tooltip, number == "nth" };
                 }
             }
         }
@@ -474,18 +499,25 @@ void Library::parseDocumentation(String const& path)
         }
     }
 
-    for (auto& [category, objects] : objectCategories) {
+    for (auto& [category, objects] : documentation.categories) {
         objects.removeDuplicates(true);
     }
+
+    return documentation;
 }
 
 Suggestions Library::autocomplete(String query) const
 {
-    Suggestions result;
-    if (searchTree)
-        searchTree->autocomplete(std::move(query), result);
+    std::shared_ptr<RadixTree const> tree;
+    {
+        SpinLock::ScopedLockType lock(searchTreeLock);
+        tree = searchTree;
+    }
 
-    return result;
+    if (tree)
+        return tree->autocomplete(query);
+
+    return {};
 }
 
 void Library::getExtraSuggestions(int currentNumSuggestions, String query, std::function<void(Suggestions)> callback)
@@ -494,78 +526,20 @@ void Library::getExtraSuggestions(int currentNumSuggestions, String query, std::
     if (currentNumSuggestions > maxSuggestions)
         return;
 
-    libraryUpdateThread.addJob([this, callback, currentNumSuggestions, query]() mutable {
-        // if(!libraryLock.try_lock()) {
-        //    return;
-        //}
-
-        Suggestions result;
-
-        Suggestions matches;
-        for (const auto& object : allObjects) {
-            // Whitespace is not supported by our autocompletion, because normally it indicates the start of the arguments
-            if (object.contains(" "))
-                continue;
-
-            if (object.contains(query)) {
-                matches.add(object);
-            }
-        }
-
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
-
-        if (currentNumSuggestions + result.size() < maxSuggestions) {
-            for (const auto& [object, keywords] : objectKeywords) {
-                if (object.contains(" "))
-                    continue;
-                for (const auto& keyword : keywords) {
-                    if (keyword.contains(query)) {
-                        matches.add(object);
-                    }
-                }
-            }
-        }
-
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
-
-        if (currentNumSuggestions + result.size() < maxSuggestions) {
-            for (const auto& [object, description] : objectDescriptions) {
-                if (object.contains(" "))
-                    continue;
-                if (description.contains(query)) {
-                    matches.add(object);
-                }
-            }
-        }
+    // Only the latest query matters: searches for older keystrokes give up as soon as they notice a newer one
+    auto const generation = ++searchGeneration;
+    auto isStale = [this, generation]() {
+        return searchGeneration.load() != generation;
+    };
 
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
-
-        if (currentNumSuggestions + result.size() > maxSuggestions) {
-            for (auto& [object, iolets] : ioletDescriptions) {
-                if (object.contains(" "))
-                    continue;
-                for (int type = 0; type < 2; type++) {
-                    auto descriptions = iolets[type];
-                    for (auto& [description, type] : descriptions) {
-                        if (description.contains(query)) {
-                            matches.add(object);
-                        }
-                    }
-                }
-            }
-        }
+    libraryUpdateThread.addJob([this, callback, query, isStale]() mutable {
+        if (isStale() || !searchIndex)
+            return;
 
-        matches.sort(true);
-        result.addArray(matches);
-        matches.clear();
+        auto result = searchIndex->search(query, maxSuggestions, isStale);
 
-        // libraryLock.unlock();
+        if (isStale())
+            return;
 
         MessageManager::callAsync([callback, result]() {
             callback(result);
@@ -575,62 +549,44 @@ void Library::getExtraSuggestions(int currentNumSuggestions, String query, std::
 
 String Library::getObjectTooltip(String const& type)
 {
-    if (libraryLock.try_lock()) {
-        return objectDescriptions[type];
-        libraryLock.unlock();
-    }
-
-    return "";
+    return getObjectDescription(type);
 }
 
 std::array<StringArray, 2> Library::getIoletTooltips(String type, String name, int numIn, int numOut)
 {
     auto args = StringArray::fromTokens(name.fromFirstOccurrenceOf(" ", false, false), true);
 
-    IODescriptionMap const* map = nullptr;
-    if (libraryLock.try_lock()) {
-        map = &ioletDescriptions;
-        libraryLock.unlock();
-    }
-
     auto result = std::array<StringArray, 2>();
 
-    if (!map) {
-        return result;
-    }
-
-    // TODO: replace with map.contains once all compilers support this!
-    if (map->count(type)) {
-        auto const& ioletDescriptions = map->at(type);
+    auto const ioletDescriptions = getIoletDescriptions(type);
 
-        for (int type = 0; type < 2; type++) {
-            int total = type ? numOut : numIn;
-            auto descriptions = ioletDescriptions[type];
-            // if the amount of inlets is not equal to the amount in the spec, look for repeating iolets
-            if (descriptions.size() < total) {
-                for (int i = 0; i < descriptions.size(); i++) {
-                    if (descriptions[i].second) { // repeating inlet found
-                        for (int j = 0; j < (total - descriptions.size()) + 1; j++) {
+    for (int type = 0; type < 2; type++) {
+        int total = type ? numOut : numIn;
+        auto descriptions = ioletDescriptions[type];
+        // if the amount of inlets is not equal to the amount in the spec, look for repeating iolets
+        if (descriptions.size() < total) {
+            for (int i = 0; i < descriptions.size(); i++) {
+                if (descriptions[i].second) { // repeating inlet found
+                    for (int j = 0; j < (total - descriptions.size()) + 1; j++) {
 
-                            auto description = descriptions[i].first;
-                            description = description.replace("$mth", String(j));
-                            description = description.replace("$nth", String(j + 1));
+                        auto description = descriptions[i].first;
+                        description = description.replace("$mth", String(j));
+                        description = description.replace("$nth", String(j + 1));
 
-                            if (isPositiveAndBelow(j, args.size())) {
-                                description = description.replace("$arg", args[j]);
-                            }
-
-                            result[type].add(description);
+                        if (isPositiveAndBelow(j, args.size())) {
+                            description = description.replace("$arg", args[j]);
                         }
-                    } else {
-                        result[type].add(descriptions[i].first);
+
+                        result[type].add(description);
                     }
-                }
-            } else {
-                for (int i = 0; i < descriptions.size(); i++) {
+                } else {
                     result[type].add(descriptions[i].first);
                 }
             }
+        } else {
+            for (int i = 0; i < descriptions.size(); i++) {
+                result[type].add(descriptions[i].first);
+            }
         }
     }
 
@@ -639,6 +595,7 @@ std::array<StringArray, 2> Library::getIoletTooltips(String type, String name, i
 
 StringArray Library::getAllObjects()
 {
+    SpinLock::ScopedLockType lock(searchTreeLock);
     return allObjects;
 }
 
@@ -716,14 +673,20 @@ File Library::findHelpfile(t_object* obj, File parentPatchFile)
     return File();
 }
 
+std::shared_ptr<DocumentationIndex const> Library::getDocumentation() const
+{
+    SpinLock::ScopedLockType lock(documentationLock);
+    return documentation;
+}
+
 ObjectMap Library::getObjectDescriptions()
 {
-    if (libraryLock.try_lock()) {
-        auto descriptions = objectDescriptions;
-        libraryLock.unlock();
-        return descriptions;
+    ObjectMap descriptions;
+    auto const currentDocumentation = getDocumentation();
+    for (auto const& name : currentDocumentation->getObjectNames()) {
+        descriptions[name] = currentDocumentation->getDescription(name);
     }
-    return {};
+    return descriptions;
 }
 KeywordMap Library::getObjectKeywords()
 {
@@ -736,42 +699,32 @@ KeywordMap Library::getObjectKeywords()
 }
 CategoryMap Library::getObjectCategories()
 {
-    if (libraryLock.try_lock()) {
-        auto categories = objectCategories;
-        libraryLock.unlock();
-        return categories;
-    }
-    return {};
+    return getDocumentation()->getAllCategories();
 }
-IODescriptionMap Library::getIoletDescriptions()
+
+String Library::getObjectDescription(String const& name)
 {
-    if (libraryLock.try_lock()) {
-        auto descriptions = ioletDescriptions;
-        libraryLock.unlock();
-        return descriptions;
-    }
+    return getDocumentation()->getDescription(name);
+}
 
-    return {};
+std::array<IODescription, 2> Library::getIoletDescriptions(String const& name)
+{
+    return getDocumentation()->getIoletDescriptions(name);
 }
 
-ArgumentMap Library::getArguments()
+Arguments Library::getArguments(String const& name)
 {
-    if (libraryLock.try_lock()) {
-        auto args = arguments;
-        libraryLock.unlock();
-        return args;
-    }
-    return {};
+    return getDocumentation()->getArguments(name);
 }
 
-MethodMap Library::getMethods()
+Methods Library::getMethods(String const& name)
 {
-    if (libraryLock.try_lock()) {
-        auto m = methods;
-        libraryLock.unlock();
-        return m;
-    }
-    return {};
+    return getDocumentation()->getMethods(name);
+}
+
+StringArray Library::getObjectCategories(String const& name)
+{
+    return getDocumentation()->getCategories(name);
 }
 
 } // namespace pd
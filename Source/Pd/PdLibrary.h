@@ -10,62 +10,49 @@
 #include <m_pd.h>
 
 #include "../Utility/FileSystemWatcher.h"
+#include "PdDocumentationIndex.h"
+#include "PdSearchIndex.h"
 
 #include <array>
+#include <limits>
 #include <vector>
 
 namespace pd {
 
-using IODescription = Array<std::pair<String, bool>>;
-using IODescriptionMap = std::unordered_map<String, std::array<IODescription, 2>>;
-
 using Suggestions = StringArray;
-
-using Arguments = std::vector<std::tuple<String, String, String>>;
-using ArgumentMap = std::unordered_map<String, Arguments>;
-
-using Methods = std::vector<std::pair<String, String>>;
-using MethodMap = std::unordered_map<String, Methods>;
-
-using ObjectMap = std::unordered_map<String, String>;
 using KeywordMap = std::unordered_map<String, StringArray>;
-using CategoryMap = std::unordered_map<String, StringArray>;
-// Define the character size
-#define CHAR_SIZE 128
-#define CHAR_TO_INDEX(c) (static_cast<int>(c) - static_cast<int>('\0'))
-#define INDEX_TO_CHAR(c) static_cast<char>(c + static_cast<int>('\0'))
-// A class to store a Trie node
-class Trie {
+// Compressed radix tree for object name autocompletion
+// Built once from a list of names and never modified afterwards, so it can be shared between threads without locking
+// All nodes and strings live in flat arrays, instead of one allocation per character
+class RadixTree {
 public:
-    bool isLeaf;
-    Trie* character[CHAR_SIZE];
+    struct Entry {
+        String name;
+        int weight; // Higher weights come first in the results
+    };
 
-    // Constructor
-    Trie()
-    {
-        isLeaf = false;
+    explicit RadixTree(std::vector<Entry> entries);
 
-        for (int i = 0; i < CHAR_SIZE; i++) {
-            character[i] = nullptr;
-        }
-    }
+    // All names that start with the query, ordered by weight, names with equal weight are ordered alphabetically
+    Suggestions autocomplete(String const& query, int maxResults = std::numeric_limits<int>::max()) const;
 
-    ~Trie()
-    {
-        for (int i = 0; i < CHAR_SIZE; i++) {
-            if (character[i]) {
-                delete character[i];
-            }
-        }
-    }
+    size_t getNumNames() const { return numNames; }
+
+private:
+    struct Node {
+        uint32 labelStart, labelLength; // Part of the name that leads to this node, in the names buffer
+        uint32 nameStart, nameLength;   // Only used if this node ends a name
+        uint32 firstChild, numChildren; // Children are in alphabetical order
+        int weight;                     // Weight of the name that ends here, or -1 if no name ends here
+        int bestWeight;                 // Highest weight in this subtree
+    };
 
-    void insert(String key);
-    bool deletion(Trie*&, String);
-    bool search(String const&);
-    bool hasChildren();
+    uint32 build(std::vector<std::pair<std::string, int>> const& sorted, size_t begin, size_t end, size_t parentDepth, size_t depth, std::vector<uint32> const& nameOffsets);
 
-    void suggestionsRec(String currPrefix, Suggestions& result);
-    int autocomplete(String query, Suggestions& result);
+    std::string names;
+    std::vector<Node> nodes;
+    std::vector<uint32> children;
+    size_t numNames = 0;
 };
 
 class Library : public FileSystemWatcher::Listener {
@@ -79,7 +66,7 @@ public:
     void initialiseLibrary();
 
     void updateLibrary();
-    void parseDocumentation(String const& path);
+    static DocumentationIndex::Documentation parseDocumentation(String const& path);
 
     Suggestions autocomplete(String query) const;
     void getExtraSuggestions(int currentNumSuggestions, String query, std::function<void(Suggestions)> callback);
@@ -98,10 +85,14 @@ public:
     ObjectMap getObjectDescriptions();
     KeywordMap getObjectKeywords();
     CategoryMap getObjectCategories();
-    IODescriptionMap getIoletDescriptions();
     StringArray getAllObjects();
-    ArgumentMap getArguments();
-    MethodMap getMethods();
+
+    // Lookups for a single object, these only read what they need from the documentation index
+    String getObjectDescription(String const& name);
+    std::array<IODescription, 2> getIoletDescriptions(String const& name);
+    Arguments getArguments(String const& name);
+    Methods getMethods(String const& name);
+    StringArray getObjectCategories(String const& name);
 
     std::function<void()> appDirChanged;
 
@@ -120,18 +111,24 @@ public:
     static inline StringArray objectOrigins = { "vanilla", "ELSE", "cyclone", "heavylib", "pdlua" };
 
 private:
-    ObjectMap objectDescriptions;
     KeywordMap objectKeywords;
-    CategoryMap objectCategories;
-    IODescriptionMap ioletDescriptions;
-    ArgumentMap arguments;
-    MethodMap methods;
+
+    // Swapped in as a whole once the update thread loaded it, so lookups never have to wait for the update to finish
+    std::shared_ptr<DocumentationIndex const> documentation = std::make_shared<DocumentationIndex const>();
+    mutable SpinLock documentationLock;
+    std::shared_ptr<DocumentationIndex const> getDocumentation() const;
 
     StringArray allObjects;
 
     std::recursive_mutex libraryLock;
 
-    std::unique_ptr<Trie> searchTree = nullptr;
+    // Swapped in as a whole by the update thread, readers keep their copy alive while they use it
+    std::shared_ptr<RadixTree const> searchTree;
+    mutable SpinLock searchTreeLock; // Also protects allObjects
+
+    // Only used on the library thread, together with the documentation it gets built from
+    std::unique_ptr<SearchIndex> searchIndex;
+    std::atomic<int> searchGeneration = 0;
 
     FileSystemWatcher watcher;
 };
@@ -0,0 +1,184 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+extern "C" {
+#include <m_pd.h>
+}
+
+#include "PdPatchCache.h"
+
+namespace pd {
+
+PatchCache::~PatchCache()
+{
+    loaderThread.removeAllJobs(true, -1);
+    watcher.removeListener(this);
+}
+
+void PatchCache::prefetch(Array<File> const& files)
+{
+    for (auto const& file : files) {
+        loaderThread.addJob([this, file]() {
+            getContent(file);
+        });
+    }
+}
+
+std::optional<PatchCache::Content> PatchCache::readFile(File const& file)
+{
+    // Only pd files, binbuf_evalfile has to take care of importing max patches
+    if (!file.existsAsFile() || !file.hasFileExtension("pd"))
+        return std::nullopt;
+
+    MemoryBlock data;
+    if (!file.loadFileAsData(data))
+        return std::nullopt;
+
+    return tokenise(data.getData(), data.getSize(), file.getLastModificationTime());
+}
+
+PatchCache::Content PatchCache::tokenise(void const* data, size_t size, Time modificationTime)
+{
+    auto tokens = std::shared_ptr<t_libpd_tokens>(libpd_tokens_new(static_cast<char const*>(data), size), libpd_tokens_free);
+    auto const tokensSize = libpd_tokens_get_size(tokens.get());
+
+    return { std::move(tokens), SHA256(data, size).toHexString(), tokensSize, modificationTime };
+}
+
+void PatchCache::addContent(String const& path, Content const& content)
+{
+    if (auto it = contents.find(path); it != contents.end()) {
+        contentSize -= it->second.first.size;
+        recentFiles.erase(it->second.second);
+        contents.erase(it);
+    }
+
+    recentFiles.push_front(path);
+    contents[path] = { content, recentFiles.begin() };
+    contentSize += content.size;
+
+    // Drop the files that were used least recently, but always keep the one we just added
+    while (contentSize > maxContentSize && recentFiles.size() > 1) {
+        auto oldest = contents.find(recentFiles.back());
+        contentSize -= oldest->second.first.size;
+        contents.erase(oldest);
+        recentFiles.pop_back();
+    }
+}
+
+std::optional<PatchCache::Content> PatchCache::getContent(File const& file)
+{
+    auto const path = file.getFullPathName();
+
+    {
+        ScopedLock lock(contentLock);
+        if (auto it = contents.find(path); it != contents.end()) {
+            // The watcher drops changed files, but it only gets to that after a short delay
+            if (it->second.first.modificationTime == file.getLastModificationTime()) {
+                recentFiles.splice(recentFiles.begin(), recentFiles, it->second.second);
+                return it->second.first;
+            }
+
+            contentSize -= it->second.first.size;
+            recentFiles.erase(it->second.second);
+            contents.erase(it);
+        }
+    }
+
+    auto content = readFile(file);
+    if (!content)
+        return content;
+
+    {
+        ScopedLock lock(contentLock);
+        addContent(path, *content);
+    }
+
+    // The watcher can only be used from the message thread, files that were prefetched get watched once they're opened
+    if (MessageManager::existsAndIsCurrentThread()) {
+        auto const folder = file.getParentDirectory();
+        if (!watcher.getWatchedFolders().contains(folder)) {
+            if (watcher.getWatchedFolders().isEmpty())
+                watcher.addListener(this);
+
+            watcher.addFolder(folder);
+        }
+    }
+
+    return content;
+}
+
+void PatchCache::setContent(File const& file, String const& text)
+{
+    // Same bytes as the file that it gets written to
+    auto const content = tokenise(text.toRawUTF8(), text.getNumBytesAsUTF8(), file.getLastModificationTime());
+
+    ScopedLock lock(contentLock);
+    addContent(file.getFullPathName(), content);
+}
+
+t_binbuf* PatchCache::getBinbuf(Content const& content)
+{
+    if (auto it = binbufs.find(content.digest); it != binbufs.end()) {
+        recentlyUsed.remove(content.digest);
+        recentlyUsed.push_front(content.digest);
+        return it->second.first;
+    }
+
+    // The text was already tokenised without the lock, this only interns the symbols
+    auto* binbuf = libpd_tokens_to_binbuf(content.tokens.get());
+    auto const size = static_cast<size_t>(binbuf_getnatom(binbuf)) * sizeof(t_atom);
+
+    binbufs[content.digest] = { binbuf, size };
+    recentlyUsed.push_front(content.digest);
+    binbufSize += size;
+
+    // Drop the binbufs that were used least recently, but never the one we're about to return
+    while (binbufSize > maxBinbufSize && recentlyUsed.size() > 1) {
+        auto oldest = binbufs.find(recentlyUsed.back());
+        binbuf_free(oldest->second.first);
+        binbufSize -= oldest->second.second;
+        binbufs.erase(oldest);
+        recentlyUsed.pop_back();
+    }
+
+    return binbuf;
+}
+
+void PatchCache::clear()
+{
+    for (auto& [digest, binbuf] : binbufs) {
+        binbuf_free(binbuf.first);
+    }
+
+    binbufs.clear();
+    recentlyUsed.clear();
+    binbufSize = 0;
+
+    ScopedLock lock(contentLock);
+    contents.clear();
+    recentFiles.clear();
+    contentSize = 0;
+}
+
+void PatchCache::fsChangeCallback()
+{
+    // The watcher doesn't tell us which files changed, so check all of them
+    // Binbufs are keyed by content, so they don't get stale, they just stop being used and fall out eventually
+    ScopedLock lock(contentLock);
+    for (auto it = contents.begin(); it != contents.end();) {
+        auto const file = File(it->first);
+        if (!file.existsAsFile() || file.getLastModificationTime() != it->second.first.modificationTime) {
+            contentSize -= it->second.first.size;
+            recentFiles.erase(it->second.second);
+            it = contents.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}
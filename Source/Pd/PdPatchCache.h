@@ -0,0 +1,78 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <m_pd.h>
+#include "x_libpd_extra_utils.h"
+
+#include "../Utility/FileSystemWatcher.h"
+
+#include <list>
+#include <map>
+#include <optional>
+
+namespace pd {
+
+// Keeps patch files around tokenised and as binbufs, so opening the same patch again doesn't have to read and parse it again
+// Binbufs are keyed by a SHA-256 of the file content: patches with the same content share one, also when they came from the DAW state
+// Reading and tokenising files can happen on any thread, only interning the symbols into a binbuf needs the pd lock
+// Abstractions aren't cached, pd loads those itself
+class PatchCache : public FileSystemWatcher::Listener {
+
+public:
+    struct Content {
+        std::shared_ptr<t_libpd_tokens> tokens;
+        String digest;
+        size_t size = 0;
+        Time modificationTime;
+    };
+
+    ~PatchCache() override;
+
+    // Starts reading these files on the loader thread, so they're ready by the time they get opened
+    void prefetch(Array<File> const& files);
+
+    // Returns the content of a file, reading it if it isn't in the cache or changed on disk
+    std::optional<Content> getContent(File const& file);
+
+    // For patches that we already have in memory, like the ones in the DAW state
+    void setContent(File const& file, String const& text);
+
+    // Call with the pd lock held, the returned binbuf stays valid until the next call
+    t_binbuf* getBinbuf(Content const& content);
+
+    // Call with the pd lock held
+    void clear();
+
+    void fsChangeCallback() override;
+
+private:
+    static std::optional<Content> readFile(File const& file);
+    // Tokenises the bytes as they are, like binbuf_read does, so the result doesn't depend on the encoding
+    static Content tokenise(void const* data, size_t size, Time modificationTime);
+
+    // Call with the content lock held
+    void addContent(String const& path, Content const& content);
+
+    CriticalSection contentLock;
+    std::map<String, std::pair<Content, std::list<String>::iterator>> contents;
+    std::list<String> recentFiles; // Most recently used first
+    size_t contentSize = 0;
+    static constexpr size_t maxContentSize = 32 * 1024 * 1024;
+
+    // Only touched with the pd lock held
+    std::map<String, std::pair<t_binbuf*, size_t>> binbufs; // With the size of its atoms
+    std::list<String> recentlyUsed; // Most recently used first
+    size_t binbufSize = 0;
+    static constexpr size_t maxBinbufSize = 32 * 1024 * 1024;
+
+    ThreadPool loaderThread = ThreadPool(1);
+    FileSystemWatcher watcher;
+};
+
+}
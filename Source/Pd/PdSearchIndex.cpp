@@ -0,0 +1,174 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "PdSearchIndex.h"
+
+namespace pd {
+
+SearchIndex::SearchIndex(std::vector<Document> const& documents)
+{
+    std::unordered_map<std::string, uint32> termIds;
+
+    float totalLength = 0.0f;
+    for (auto const& document : documents) {
+        auto const documentIndex = static_cast<uint32>(names.size());
+        names.push_back(document.name);
+
+        // Term id to weighted frequency within this document
+        std::unordered_map<uint32, float> frequencies;
+
+        // The whole name as one word as well, so "list-drip" can be found by "t-d"
+        addTerm(document.name.toLowerCase().toStdString(), NameField, termIds, frequencies);
+        addText(documentIndex, document.name, NameField, termIds, frequencies);
+
+        for (auto const& keyword : document.keywords)
+            addText(documentIndex, keyword, KeywordField, termIds, frequencies);
+
+        addText(documentIndex, document.description, DescriptionField, termIds, frequencies);
+
+        for (auto const& iolet : document.ioletDescriptions)
+            addText(documentIndex, iolet, IoletField, termIds, frequencies);
+
+        float length = 0.0f;
+        for (auto const& [term, frequency] : frequencies) {
+            postings[term].push_back({ documentIndex, frequency });
+            length += frequency;
+        }
+
+        documentLengths.push_back(length);
+        totalLength += length;
+    }
+
+    averageLength = documents.empty() ? 1.0f : std::max(totalLength / static_cast<float>(documents.size()), 1.0f);
+
+    for (uint32 term = 0; term < static_cast<uint32>(terms.size()); term++) {
+        auto const& text = terms[term];
+        for (size_t i = 0; i + 3 <= text.size(); i++) {
+            auto& termsWithTrigram = trigrams[getTrigram(text.data() + i)];
+            if (termsWithTrigram.empty() || termsWithTrigram.back() != term)
+                termsWithTrigram.push_back(term);
+        }
+    }
+}
+
+uint32 SearchIndex::getTrigram(char const* text)
+{
+    return static_cast<uint32>(static_cast<unsigned char>(text[0])) << 16 | static_cast<uint32>(static_cast<unsigned char>(text[1])) << 8 | static_cast<uint32>(static_cast<unsigned char>(text[2]));
+}
+
+void SearchIndex::addText(uint32 document, String const& text, Field field, std::unordered_map<std::string, uint32>& termIds, std::unordered_map<uint32, float>& frequencies)
+{
+    auto const lowercase = text.toLowerCase().toStdString();
+
+    // Words are made of letters, digits and tildes, anything outside of ascii counts as a letter
+    auto isWordCharacter = [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '~' || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    };
+
+    size_t position = 0;
+    while (position < lowercase.size()) {
+        while (position < lowercase.size() && !isWordCharacter(lowercase[position]))
+            position++;
+
+        auto const start = position;
+        while (position < lowercase.size() && isWordCharacter(lowercase[position]))
+            position++;
+
+        if (position == start)
+            continue;
+
+        addTerm(lowercase.substr(start, position - start), field, termIds, frequencies);
+    }
+}
+
+void SearchIndex::addTerm(std::string word, Field field, std::unordered_map<std::string, uint32>& termIds, std::unordered_map<uint32, float>& frequencies)
+{
+    auto [it, inserted] = termIds.try_emplace(std::move(word), static_cast<uint32>(terms.size()));
+    if (inserted) {
+        terms.push_back(it->first);
+        postings.emplace_back();
+    }
+
+    frequencies[it->second] += fieldWeights[field];
+}
+
+StringArray SearchIndex::search(String const& query, int maxResults, std::function<bool()> const& shouldStop) const
+{
+    auto const key = query.toLowerCase().toStdString();
+    if (key.empty())
+        return {};
+
+    // Find the words that contain the query
+    std::vector<uint32> matchingTerms;
+    if (key.size() >= 3) {
+        // Start with the rarest trigram of the query, every other trigram can only remove candidates
+        std::vector<std::vector<uint32> const*> lists;
+        for (size_t i = 0; i + 3 <= key.size(); i++) {
+            auto it = trigrams.find(getTrigram(key.data() + i));
+            if (it == trigrams.end())
+                return {};
+
+            lists.push_back(&it->second);
+        }
+
+        std::sort(lists.begin(), lists.end(), [](auto const* a, auto const* b) { return a->size() < b->size(); });
+
+        for (auto term : *lists.front()) {
+            auto const inAllLists = std::all_of(lists.begin() + 1, lists.end(), [term](auto const* list) { return std::binary_search(list->begin(), list->end(), term); });
+
+            // Trigrams can match in the wrong order, so check the actual word too
+            if (inAllLists && terms[term].find(key) != std::string::npos)
+                matchingTerms.push_back(term);
+        }
+    } else {
+        // Too short for trigrams, but the vocabulary is small enough to scan
+        for (uint32 term = 0; term < static_cast<uint32>(terms.size()); term++) {
+            if ((term & 1023) == 0 && shouldStop())
+                return {};
+
+            if (terms[term].find(key) != std::string::npos)
+                matchingTerms.push_back(term);
+        }
+    }
+
+    if (shouldStop())
+        return {};
+
+    // BM25, where a word that only contains the query counts for less than a word that starts with it or is equal to it
+    auto const numDocuments = static_cast<float>(names.size());
+    std::unordered_map<uint32, float> scores;
+    for (auto term : matchingTerms) {
+        auto const& termPostings = postings[term];
+        auto const documentFrequency = static_cast<float>(termPostings.size());
+        auto const idf = std::log(1.0f + (numDocuments - documentFrequency + 0.5f) / (documentFrequency + 0.5f));
+
+        auto const& text = terms[term];
+        auto const matchQuality = text == key ? 1.0f : (text.compare(0, key.size(), key) == 0 ? 0.75f : 0.5f);
+
+        for (auto const& [document, frequency] : termPostings) {
+            auto const normalisation = k1 * (1.0f - b + b * documentLengths[document] / averageLength);
+            scores[document] += matchQuality * idf * frequency * (k1 + 1.0f) / (frequency + normalisation);
+        }
+    }
+
+    std::vector<std::pair<uint32, float>> ranked(scores.begin(), scores.end());
+    auto const numResults = std::min<size_t>(ranked.size(), static_cast<size_t>(std::max(maxResults, 0)));
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<long>(numResults), ranked.end(), [this](auto const& a, auto const& b) {
+        return a.second != b.second ? a.second > b.second : names[a.first] < names[b.first];
+    });
+
+    StringArray result;
+    for (size_t i = 0; i < numResults; i++) {
+        result.add(names[ranked[i].first]);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pd {
+
+// Full text search over object names and their documentation, for the suggestions that don't start with what was typed
+// Every word gets a list of the objects it appears in, and every three letter sequence gets a list of the words it appears in
+// That way substring queries only have to look at the words that could contain them, results are ranked with BM25
+class SearchIndex {
+
+public:
+    struct Document {
+        String name;
+        String description;
+        StringArray keywords;
+        StringArray ioletDescriptions;
+    };
+
+    explicit SearchIndex(std::vector<Document> const& documents);
+
+    // Objects that contain the query in their name or documentation, best matches first
+    // shouldStop gets checked regularly, when it returns true the search gives up and returns nothing
+    StringArray search(String const& query, int maxResults, std::function<bool()> const& shouldStop) const;
+
+private:
+    enum Field {
+        NameField,
+        KeywordField,
+        DescriptionField,
+        IoletField,
+        NumFields
+    };
+
+    // Words in the name count a lot more than words somewhere in the iolet descriptions
+    static constexpr float fieldWeights[NumFields] = { 4.0f, 2.0f, 1.0f, 0.5f };
+
+    // BM25 parameters
+    static constexpr float k1 = 1.2f;
+    static constexpr float b = 0.75f;
+
+    struct Posting {
+        uint32 document;
+        float frequency; // Weighted by the fields the word appeared in
+    };
+
+    void addText(uint32 document, String const& text, Field field, std::unordered_map<std::string, uint32>& termIds, std::unordered_map<uint32, float>& frequencies);
+    void addTerm(std::string word, Field field, std::unordered_map<std::string, uint32>& termIds, std::unordered_map<uint32, float>& frequencies);
+    static uint32 getTrigram(char const* text);
+
+    std::vector<String> names;
+    std::vector<float> documentLengths;
+    float averageLength = 1.0f;
+
+    std::vector<std::string> terms;
+    std::vector<std::vector<Posting>> postings;         // By term
+    std::unordered_map<uint32, std::vector<uint32>> trigrams; // Sorted term ids by trigram
+};
+
+}
@@ -380,6 +380,14 @@ bool PluginEditor::isInterestedInFileDrag(StringArray const& files)
 
 void PluginEditor::filesDropped(StringArray const& files, int x, int y)
 {
+    // Let the loader thread read the other patches while we're opening the first ones
+    Array<File> patchFiles;
+    for (auto& path : files) {
+        if (File(path).hasFileExtension("pd"))
+            patchFiles.add(File(path));
+    }
+    pd->patchCache.prefetch(patchFiles);
+
     for (auto& path : files) {
         auto file = File(path);
         if (file.exists() && (file.isDirectory() || file.hasFileExtension("pd"))) {
@@ -1102,17 +1110,17 @@ bool PluginEditor::perform(InvocationInfo const& info)
         return true;
     }
     case CommandIDs::ConnectionPathfind: {
-        cnv->patch.startUndoSequence("ConnectionPathFind");
+        auto const connections = cnv->getSelectionOfType<Connection>();
 
-        statusbar.connectionStyleButton->setToggleState(true, sendNotification);
-        for (auto* con : cnv->connections) {
-            if (cnv->isSelected(con)) {
-                con->findPath();
-                con->updatePath();
-            }
-        }
+        // Routes all selected connections in one go, the ConnectionPathUpdater groups the results into a single undo step
+        // Queued before they become segmented, so they don't each request a route of their own as well
+        cnv->router->route(connections);
 
-        cnv->patch.endUndoSequence("ConnectionPathFind");
+        // Not through the button's onClick, that would make them segmented one by one again
+        statusbar.connectionStyleButton->setToggleState(true, dontSendNotification);
+        for (auto* connection : connections) {
+            connection->setSegmented(true);
+        }
 
         return true;
     }
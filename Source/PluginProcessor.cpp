@@ -10,6 +10,7 @@
 #    include "Utility/OSUtils.h"
 #endif
 
+#include <bit>
 #include <clocale>
 #include "PluginProcessor.h"
 
@@ -19,6 +20,7 @@
 #include "Tabbar.h"
 
 #include "Utility/PluginParameter.h"
+#include "Utility/AudioSanitiser.h"
 
 extern "C" {
 #include "x_libpd_extra_utils.h"
@@ -80,6 +82,11 @@ PluginProcessor::PluginProcessor()
         addParameter(parameter);
     }
 
+    // Make sure the initial values get sent on the first tick
+    for (int n = 0; n <= numParameters; n++) {
+        markParameterDirty(n);
+    }
+
     // Make sure that the parameter valuetree has a name, to prevent assertion failures
     // parameters.replaceState(ValueTree("plugdata"));
 
@@ -100,6 +107,25 @@ PluginProcessor::PluginProcessor()
     atoms_playhead.reserve(3);
     atoms_playhead.resize(1);
 
+    playheadSymbols = {
+        generateSymbolHandle("playhead"),
+        generateSymbolHandle("playing"),
+        generateSymbolHandle("recording"),
+        generateSymbolHandle("looping"),
+        generateSymbolHandle("edittime"),
+        generateSymbolHandle("framerate"),
+        generateSymbolHandle("bpm"),
+        generateSymbolHandle("lastbar"),
+        generateSymbolHandle("timesig"),
+        generateSymbolHandle("position"),
+    };
+
+    midiInputSymbols = {
+        generateSymbolHandle("#midiin"),
+        generateSymbolHandle("#sysexin"),
+        generateSymbolHandle("#midirealtimein"),
+    };
+
     setCallbackLock(&AudioProcessor::getCallbackLock());
 
     sendMessagesFromQueue();
@@ -137,6 +163,7 @@ PluginProcessor::PluginProcessor()
     settingsFile->saveSettings();
 
     oversampling = settingsFile->getProperty<int>("oversampling");
+    oversamplingFilter = settingsFile->getProperty<int>("oversampling_filter");
 
     setProtectedMode(settingsFile->getProperty<int>("protected"));
 #if PLUGDATA_STANDALONE
@@ -161,7 +188,7 @@ PluginProcessor::PluginProcessor()
         objectLibrary.initialiseLibrary();
     }
 
-    setLatencySamples(pd::Instance::getBlockSize());
+    setLatencySamples(dspBlockSize);
 
 #if PLUGDATA_STANDALONE && !JUCE_WINDOWS
     if (auto* newOut = MidiOutput::createNewDevice("from plugdata").release()) {
@@ -174,6 +201,8 @@ PluginProcessor::~PluginProcessor()
 {
     // Deleting the pd instance in ~PdInstance() will also free all the Pd patches
     patches.clear();
+
+    delete pendingOversampler.exchange(nullptr);
 }
 
 void PluginProcessor::initialiseFilesystem()
@@ -362,12 +391,138 @@ void PluginProcessor::setOversampling(int amount)
     settingsFile->saveSettings(); // TODO: i think this is unnecessary?
 
     oversampling = amount;
-    auto blockSize = AudioProcessor::getBlockSize();
-    auto sampleRate = AudioProcessor::getSampleRate();
+    updateOversampling();
+}
+
+void PluginProcessor::setOversamplingFilter(int filter)
+{
+    settingsFile->setProperty("oversampling_filter", var(filter));
+
+    oversamplingFilter = filter;
+    updateOversampling();
+}
+
+std::unique_ptr<dsp::Oversampling<float>> PluginProcessor::createOversampler(int amount, int filter, int samplesPerBlock) const
+{
+    auto const maxChannels = std::max(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    auto const filterType = filter == LinearPhaseFIR ? dsp::Oversampling<float>::filterHalfBandFIREquiripple : dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+
+    // Linear phase needs the integer latency version, so the latency we report is exact
+    auto newOversampler = std::make_unique<dsp::Oversampling<float>>(maxChannels, amount, filterType, true, filter == LinearPhaseFIR);
+    newOversampler->initProcessing(samplesPerBlock);
+    return newOversampler;
+}
+
+void PluginProcessor::updateOversampling()
+{
+    // Not prepared yet, prepareToPlay will pick up the new settings
+    if (requestedOversampling < 0 || AudioProcessor::getSampleRate() <= 0.0)
+        return;
+
+    auto const amount = oversampling.load();
+    auto const filter = oversamplingFilter.load();
+    auto const amountChanged = requestedOversampling.exchange(amount) != amount;
+    auto const filterChanged = requestedOversamplingFilter.exchange(filter) != filter;
+    if (!amountChanged && !filterChanged)
+        return;
+
+    // Do all the allocating here, the audio thread only swaps it in once it faded out
+    // If it didn't get to the previous one yet, this one replaces it
+    auto* next = new OversamplerSwitch { createOversampler(amount, filter, AudioProcessor::getBlockSize()), amount };
+    delete pendingOversampler.exchange(next, std::memory_order_acq_rel);
+}
+
+void PluginProcessor::switchOversampler()
+{
+    // Wait until the message thread freed the last one we replaced, so we never free anything here
+    if (retiredOversampler)
+        return;
+
+    std::unique_ptr<OversamplerSwitch> next(pendingOversampler.exchange(nullptr, std::memory_order_acq_rel));
+    if (!next)
+        return;
+
+    oversampler.swap(next->oversampler);
+    auto const previousOversampling = std::exchange(activeOversampling, next->amount);
+    retiredOversampler = std::move(next);
+
+    // A new filter leaves Pd alone, a new factor only has to tell Pd its new sample rate
+    // The DSP keeps running, so the patches and their state stay as they are
+    if (activeOversampling != previousOversampling) {
+        auto const oversampleFactor = 1 << activeOversampling;
+        prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), AudioProcessor::getSampleRate() * oversampleFactor, AudioProcessor::getBlockSize() * oversampleFactor);
+
+        // Whatever we had buffered was at the old rate
+        audioAdvancement = 0;
+        std::fill(audioBufferOut.begin(), audioBufferOut.end(), 0.f);
+        std::fill(audioBufferIn.begin(), audioBufferIn.end(), 0.f);
+        midiBufferIn.clear();
+        midiBufferOut.clear();
+
+        zeroLatencyActive = zeroLatencyMode && (AudioProcessor::getBlockSize() * oversampleFactor) % blockSize == 0;
+        zeroLatencyFallback = zeroLatencyMode && !zeroLatencyActive;
+    }
+
+    latencyUpdater.triggerAsyncUpdate();
+}
+
+void PluginProcessor::updateLatency()
+{
+    auto const filterLatency = oversampler ? static_cast<int>(std::ceil(oversampler->getLatencyInSamples())) : 0;
+    setLatencySamples(getBaseLatency() + filterLatency);
+}
+
+int PluginProcessor::getBaseLatency() const
+{
+    if (customLatency >= 0)
+        return customLatency;
+
+    // Our own buffering happens at Pd's sample rate, the host wants to know the latency at its own rate
+    return zeroLatencyActive && !zeroLatencyFallback ? 0 : blockSize >> activeOversampling;
+}
+
+void PluginProcessor::setBaseLatency(int samples)
+{
+    customLatency = std::max(samples, -1);
+
+    ScopedLock lock(getCallbackLock());
+    updateLatency();
+}
+
+void PluginProcessor::setDSPBlockSize(int newBlockSize)
+{
+    // Pd's own block size is fixed at compile time, so we can only process in multiples of it
+    auto const tick = Instance::getBlockSize();
+    auto const roundedBlockSize = std::max(tick, (newBlockSize / tick) * tick);
+
+    if (dspBlockSize == roundedBlockSize)
+        return;
+
+    dspBlockSize = roundedBlockSize;
+    reprepare();
+}
+
+void PluginProcessor::setZeroLatencyMode(bool enabled)
+{
+    if (zeroLatencyMode == enabled)
+        return;
+
+    zeroLatencyMode = enabled;
+    reprepare();
+}
+
+void PluginProcessor::reprepare()
+{
+    // Not prepared yet, prepareToPlay will pick up the new settings
+    if (AudioProcessor::getSampleRate() <= 0.0)
+        return;
+
+    // Don't resume processing if it was suspended by someone else, like setStateInformation
+    auto const wasSuspended = isSuspended();
 
     suspendProcessing(true);
-    prepareToPlay(sampleRate, blockSize);
-    suspendProcessing(false);
+    prepareToPlay(AudioProcessor::getSampleRate(), AudioProcessor::getBlockSize());
+    suspendProcessing(wasSuspended);
 }
 
 void PluginProcessor::setProtectedMode(bool enabled)
@@ -377,14 +532,24 @@ void PluginProcessor::setProtectedMode(bool enabled)
 
 void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    float oversampleFactor = 1 << oversampling;
+    activeOversampling = oversampling;
+    float oversampleFactor = 1 << activeOversampling;
     auto maxChannels = std::max(getTotalNumInputChannels(), getTotalNumOutputChannels());
 
     prepareDSP(getTotalNumInputChannels(), getTotalNumOutputChannels(), sampleRate * oversampleFactor, samplesPerBlock * oversampleFactor);
 
-    oversampler.reset(new dsp::Oversampling<float>(maxChannels, oversampling, dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, false));
+    oversampler = createOversampler(activeOversampling, oversamplingFilter, samplesPerBlock);
 
-    oversampler->initProcessing(samplesPerBlock);
+    // We just created one with the current settings, so anything still waiting to be swapped in is outdated
+    delete pendingOversampler.exchange(nullptr);
+    requestedOversampling = activeOversampling;
+    requestedOversamplingFilter = oversamplingFilter.load();
+
+    switchGain.reset(sampleRate, 0.01);
+    switchGain.setCurrentAndTargetValue(1.0f);
+
+    // Make sure [playhead] gets the complete state again
+    playheadChanges = LIBPD_PLAYHEAD_ALL;
 
 #if PLUGDATA_STANDALONE
     if (enableInternalSynth) {
@@ -393,17 +558,32 @@ void PluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 #endif
 
     audioAdvancement = 0;
-    auto const blksize = static_cast<size_t>(Instance::getBlockSize());
+    blockSize = dspBlockSize;
+    auto const blksize = static_cast<size_t>(blockSize);
     auto const numIn = static_cast<size_t>(getTotalNumInputChannels());
     auto const nouts = static_cast<size_t>(getTotalNumOutputChannels());
     audioBufferIn.resize(numIn * blksize);
     audioBufferOut.resize(nouts * blksize);
     std::fill(audioBufferOut.begin(), audioBufferOut.end(), 0.f);
     std::fill(audioBufferIn.begin(), audioBufferIn.end(), 0.f);
+
+    audioChannelsIn.resize(numIn);
+    audioChannelsOut.resize(nouts);
+    for (size_t ch = 0; ch < numIn; ch++)
+        audioChannelsIn[ch] = audioBufferIn.data() + ch * blksize;
+    for (size_t ch = 0; ch < nouts; ch++)
+        audioChannelsOut[ch] = audioBufferOut.data() + ch * blksize;
+
+    // Hosts may still send smaller blocks than this, process() will fall back to buffering in that case
+    zeroLatencyActive = zeroLatencyMode && (samplesPerBlock * static_cast<int>(oversampleFactor)) % blockSize == 0;
+    zeroLatencyFallback = zeroLatencyMode && !zeroLatencyActive;
+    updateLatency();
+
     midiBufferIn.clear();
     midiBufferOut.clear();
     midiBufferTemp.clear();
 
+    midiOutputArena.clear();
     midiByteIndex = 0;
     midiByteBuffer[0] = 0;
     midiByteBuffer[1] = 0;
@@ -464,9 +644,13 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
+    ScopedTrace blockTrace(tracer, "processBlock");
+
     setThis();
-    sendPlayhead();
-    sendParameters();
+    {
+        ScopedTrace trace(tracer, "updatePlayhead");
+        updatePlayhead();
+    }
 
     for (int i = totalNumInputChannels; i < totalNumOutputChannels; ++i) {
         buffer.clear(i, 0, buffer.getNumSamples());
@@ -475,17 +659,37 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
     midiBufferCopy.clear();
     midiBufferCopy.addEvents(midiMessages, 0, buffer.getNumSamples(), audioAdvancement);
 
+    // Once we faded out for a new oversampler, swap it in before we use it
+    if (pendingOversampler.load(std::memory_order_relaxed) && !switchGain.isSmoothing() && switchGain.getCurrentValue() == 0.0f) {
+        switchOversampler();
+    }
+
     auto targetBlock = dsp::AudioBlock<float>(buffer);
-    auto blockOut = oversampling > 0 ? oversampler->processSamplesUp(targetBlock) : targetBlock;
+    auto blockOut = targetBlock;
+    if (activeOversampling > 0) {
+        ScopedTrace trace(tracer, "oversampleUp");
+        blockOut = oversampler->processSamplesUp(targetBlock);
+    }
 
     process(blockOut, midiMessages);
 
-    if (oversampling > 0) {
+    if (activeOversampling > 0) {
+        ScopedTrace trace(tracer, "oversampleDown");
         oversampler->processSamplesDown(targetBlock);
     }
 
     buffer.applyGain(getParameters()[0]->getValue());
-    statusbarSource.processBlock(buffer, midiBufferCopy, midiMessages, totalNumOutputChannels);
+
+    // Fade out while a new oversampler is waiting, and back in once it's swapped in, so the switch doesn't click
+    switchGain.setTargetValue(pendingOversampler.load(std::memory_order_relaxed) ? 0.0f : 1.0f);
+    if (switchGain.isSmoothing() || switchGain.getCurrentValue() != 1.0f) {
+        switchGain.applyGain(buffer, buffer.getNumSamples());
+    }
+
+    {
+        ScopedTrace trace(tracer, "statusbar");
+        statusbarSource.processBlock(buffer, midiBufferCopy, midiMessages, totalNumOutputChannels);
+    }
 
 #if PLUGDATA_STANDALONE
     for (auto* midiOutput : midiOutputs) {
@@ -496,6 +700,7 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
 
     // If the internalSynth is enabled and loaded, let it process the midi
     if (enableInternalSynth && internalSynth.isReady()) {
+        ScopedTrace trace(tracer, "internalSynth");
         internalSynth.process(buffer, midiMessages);
     } else if (!enableInternalSynth && internalSynth.isReady()) {
         internalSynth.unprepare();
@@ -506,25 +711,21 @@ void PluginProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiM
 #endif
 
     if (protectedMode) {
+        ScopedTrace trace(tracer, "protectedMode");
+        AudioSanitiser::Result result;
         auto* const* writePtr = buffer.getArrayOfWritePointers();
         for (int ch = 0; ch < buffer.getNumChannels(); ch++) {
-            for (int n = 0; n < buffer.getNumSamples(); n++) {
-                if (!std::isfinite(writePtr[ch][n])) {
-                    writePtr[ch][n] = 0.0f;
-                } else {
-                    writePtr[ch][n] = std::clamp(writePtr[ch][n], -1.0f, 1.0f);
-                }
-            }
+            result += AudioSanitiser::process(writePtr[ch], buffer.getNumSamples());
         }
+        statusbarSource.reportSanitisedSamples(result.numClipped, result.numReplaced);
     }
 }
 
 void PluginProcessor::process(dsp::AudioBlock<float> buffer, MidiBuffer& midiMessages)
 {
     ScopedNoDenormals noDenormals;
-    int const blockSize = Instance::getBlockSize();
     int const numSamples = static_cast<int>(buffer.getNumSamples());
-    int const adv = audioAdvancement >= 64 ? 0 : audioAdvancement;
+    int const adv = audioAdvancement >= blockSize ? 0 : audioAdvancement;
     int const numLeft = blockSize - adv;
     int const numIn = getTotalNumInputChannels();
     int const numOut = getTotalNumOutputChannels();
@@ -542,6 +743,36 @@ void PluginProcessor::process(dsp::AudioBlock<float> buffer, MidiBuffer& midiMes
         buffer.getSingleChannelBlock(ch).clear();
     }
 
+    // If nothing is left in our buffers and the host block lines up with ours,
+    // we can let Pd read and write the host channels directly
+    // Once we had to fall back to buffering, we stay there until the next prepareToPlay:
+    // going direct again would drop the block that's waiting in the output buffer, and change the latency
+    if (zeroLatencyActive && !zeroLatencyFallback.load(std::memory_order_relaxed) && audioAdvancement == 0 && numSamples % blockSize == 0) {
+        MidiBuffer const& midiin = midiProduce ? midiBufferTemp : midiMessages;
+        if (midiProduce) {
+            midiBufferTemp.swapWith(midiMessages);
+            midiMessages.clear();
+        }
+
+        auto const numChannels = static_cast<int>(channelPointers.size());
+        for (int pos = 0; pos < numSamples; pos += blockSize) {
+            if (midiConsume) {
+                midiBufferIn.addEvents(midiin, pos, blockSize, -pos);
+            }
+            processInternal(channelPointers.data(), std::min(numIn, numChannels), channelPointers.data(), std::min(numOut, numChannels), pos);
+            if (midiProduce) {
+                midiMessages.addEvents(midiBufferOut, 0, blockSize, pos);
+            }
+        }
+        return;
+    }
+
+    // The host sent a block that doesn't line up with ours, so from here on we're adding a block of latency after all
+    if (zeroLatencyActive && !zeroLatencyFallback.load(std::memory_order_relaxed)) {
+        zeroLatencyFallback = true;
+        latencyUpdater.triggerAsyncUpdate();
+    }
+
     // If the current number of samples in this block
     // is inferior to the number of samples required
     if (numSamples < numLeft) {
@@ -591,7 +822,7 @@ void PluginProcessor::process(dsp::AudioBlock<float> buffer, MidiBuffer& midiMes
             midiMessages.addEvents(midiBufferOut, adv, numLeft, -adv);
         }
         audioAdvancement = 0;
-        processInternal();
+        processInternal(audioChannelsIn.data(), numIn, audioChannelsOut.data(), numOut, 0);
 
         // If there are other DSP ticks that can be
         // performed, then we do it now.
@@ -611,7 +842,7 @@ void PluginProcessor::process(dsp::AudioBlock<float> buffer, MidiBuffer& midiMes
             if (midiProduce) {
                 midiMessages.addEvents(midiBufferOut, 0, blockSize, pos);
             }
-            processInternal();
+            processInternal(audioChannelsIn.data(), numIn, audioChannelsOut.data(), numOut, 0);
             pos += blockSize;
         }
 
@@ -639,8 +870,11 @@ void PluginProcessor::process(dsp::AudioBlock<float> buffer, MidiBuffer& midiMes
     }
 }
 
-void PluginProcessor::sendPlayhead()
+void PluginProcessor::updatePlayhead()
 {
+    playheadTickOffset = 0;
+    hasPlayhead = false;
+
     AudioPlayHead* playhead = getPlayHead();
 
     if (!playhead)
@@ -648,90 +882,128 @@ void PluginProcessor::sendPlayhead()
 
     auto infos = playhead->getPosition();
 
-    setThis();
-    if (infos.hasValue()) {
-        atoms_playhead[0] = static_cast<float>(infos->getIsPlaying());
-        sendMessage("playhead", "playing", atoms_playhead);
-
-        atoms_playhead[0] = static_cast<float>(infos->getIsRecording());
-        sendMessage("playhead", "recording", atoms_playhead);
-
-        atoms_playhead[0] = static_cast<float>(infos->getIsLooping());
-
-        auto loopPoints = infos->getLoopPoints();
-        if (loopPoints.hasValue()) {
-            atoms_playhead.push_back(static_cast<float>(loopPoints->ppqStart));
-            atoms_playhead.push_back(static_cast<float>(loopPoints->ppqEnd));
-        } else {
-            atoms_playhead.push_back(0.0f);
-            atoms_playhead.push_back(0.0f);
-        }
-        sendMessage("playhead", "looping", atoms_playhead);
+    if (!infos.hasValue())
+        return;
 
-        if (infos->getEditOriginTime().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getEditOriginTime());
-            sendMessage("playhead", "edittime", atoms_playhead);
-        }
+    hasPlayhead = true;
 
-        if (infos->getFrameRate().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getFrameRate()->getEffectiveRate());
-            sendMessage("playhead", "framerate", atoms_playhead);
-        }
+    // Fields that the host doesn't report keep their previous value
+    auto state = playheadState;
 
-        if (infos->getBpm().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getBpm());
-            sendMessage("playhead", "bpm", atoms_playhead);
-        }
+    state.playing = static_cast<float>(infos->getIsPlaying());
+    state.recording = static_cast<float>(infos->getIsRecording());
+    state.looping = static_cast<float>(infos->getIsLooping());
 
-        if (infos->getPpqPositionOfLastBarStart().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPositionOfLastBarStart());
-            sendMessage("playhead", "lastbar", atoms_playhead);
-        }
+    auto loopPoints = infos->getLoopPoints();
+    state.loop_start = loopPoints.hasValue() ? static_cast<float>(loopPoints->ppqStart) : 0.0f;
+    state.loop_end = loopPoints.hasValue() ? static_cast<float>(loopPoints->ppqEnd) : 0.0f;
 
-        if (infos->getTimeSignature().hasValue()) {
-            atoms_playhead.resize(1);
-            atoms_playhead[0] = static_cast<float>(infos->getTimeSignature()->numerator);
-            atoms_playhead.push_back(static_cast<float>(infos->getTimeSignature()->denominator));
-            sendMessage("playhead", "timesig", atoms_playhead);
-        }
+    if (infos->getEditOriginTime().hasValue())
+        state.edittime = static_cast<float>(*infos->getEditOriginTime());
 
-        if (infos->getPpqPosition().hasValue()) {
+    if (infos->getFrameRate().hasValue())
+        state.framerate = static_cast<float>(infos->getFrameRate()->getEffectiveRate());
 
-            atoms_playhead[0] = static_cast<float>(*infos->getPpqPosition());
-        } else {
-            atoms_playhead[0] = 0.0f;
-        }
+    if (infos->getBpm().hasValue())
+        state.bpm = static_cast<float>(*infos->getBpm());
 
-        if (infos->getTimeInSamples().hasValue()) {
-            atoms_playhead[1] = static_cast<float>(*infos->getTimeInSamples());
-        } else {
-            atoms_playhead[1] = 0.0f;
-        }
+    if (infos->getPpqPositionOfLastBarStart().hasValue())
+        state.lastbar = static_cast<float>(*infos->getPpqPositionOfLastBarStart());
 
-        if (infos->getTimeInSeconds().hasValue()) {
-            atoms_playhead.push_back(static_cast<float>(*infos->getTimeInSeconds()));
-        } else {
-            atoms_playhead.push_back(0.0f);
-        }
+    if (infos->getTimeSignature().hasValue()) {
+        state.timesig_numerator = static_cast<float>(infos->getTimeSignature()->numerator);
+        state.timesig_denominator = static_cast<float>(infos->getTimeSignature()->denominator);
+    }
+
+    state.ppq = infos->getPpqPosition().hasValue() ? static_cast<float>(*infos->getPpqPosition()) : 0.0f;
+    state.samples = infos->getTimeInSamples().hasValue() ? static_cast<float>(*infos->getTimeInSamples()) : 0.0f;
+    state.seconds = infos->getTimeInSeconds().hasValue() ? static_cast<float>(*infos->getTimeInSeconds()) : 0.0f;
+
+    auto const changed = [&state, this](auto... fields) {
+        return ((state.*fields != playheadState.*fields) || ...);
+    };
+
+    // Position is sent on every tick, everything else only when it changes
+    using State = t_libpd_playhead_state;
+    playheadChanges |= changed(&State::playing) ? LIBPD_PLAYHEAD_PLAYING : 0;
+    playheadChanges |= changed(&State::recording) ? LIBPD_PLAYHEAD_RECORDING : 0;
+    playheadChanges |= changed(&State::looping, &State::loop_start, &State::loop_end) ? LIBPD_PLAYHEAD_LOOPING : 0;
+    playheadChanges |= changed(&State::edittime) ? LIBPD_PLAYHEAD_EDITTIME : 0;
+    playheadChanges |= changed(&State::framerate) ? LIBPD_PLAYHEAD_FRAMERATE : 0;
+    playheadChanges |= changed(&State::bpm) ? LIBPD_PLAYHEAD_BPM : 0;
+    playheadChanges |= changed(&State::lastbar) ? LIBPD_PLAYHEAD_LASTBAR : 0;
+    playheadChanges |= changed(&State::timesig_numerator, &State::timesig_denominator) ? LIBPD_PLAYHEAD_TIMESIG : 0;
+
+    playheadState = state;
+}
+
+void PluginProcessor::sendPlayheadTick()
+{
+    if (!hasPlayhead)
+        return;
+
+    auto state = playheadState;
+    auto const changes = std::exchange(playheadChanges, 0) | LIBPD_PLAYHEAD_POSITION;
 
-        sendMessage("playhead", "position", atoms_playhead);
-        atoms_playhead.resize(1);
+    // Move the position along to where this tick starts within the host block
+    if (state.playing != 0.0f && playheadTickOffset > 0) {
+        auto const offsetInSeconds = playheadTickOffset / AudioProcessor::getSampleRate();
+        state.samples += static_cast<float>(playheadTickOffset);
+        state.seconds += static_cast<float>(offsetInSeconds);
+        state.ppq += static_cast<float>(offsetInSeconds * state.bpm / 60.0);
     }
+
+    playheadTickOffset += Instance::getBlockSize() >> activeOversampling;
+
+    libpd_playhead_send(&state, changes);
+
+    // Patches can also listen to the playhead receiver directly
+    if (!playheadSymbols.receiver.getReceiver())
+        return;
+
+    auto send = [this, changes](int flag, pd::SymbolHandle const& selector, std::initializer_list<float> values) {
+        if (!(changes & flag))
+            return;
+
+        atoms_playhead.assign(values.begin(), values.end());
+        sendMessage(playheadSymbols.receiver, selector, atoms_playhead);
+    };
+
+    send(LIBPD_PLAYHEAD_PLAYING, playheadSymbols.playing, { state.playing });
+    send(LIBPD_PLAYHEAD_RECORDING, playheadSymbols.recording, { state.recording });
+    send(LIBPD_PLAYHEAD_LOOPING, playheadSymbols.looping, { state.looping, state.loop_start, state.loop_end });
+    send(LIBPD_PLAYHEAD_EDITTIME, playheadSymbols.edittime, { state.edittime });
+    send(LIBPD_PLAYHEAD_FRAMERATE, playheadSymbols.framerate, { state.framerate });
+    send(LIBPD_PLAYHEAD_BPM, playheadSymbols.bpm, { state.bpm });
+    send(LIBPD_PLAYHEAD_LASTBAR, playheadSymbols.lastbar, { state.lastbar });
+    send(LIBPD_PLAYHEAD_TIMESIG, playheadSymbols.timesig, { state.timesig_numerator, state.timesig_denominator });
+    send(LIBPD_PLAYHEAD_POSITION, playheadSymbols.position, { state.ppq, state.samples, state.seconds });
 }
 
 void PluginProcessor::sendParameters()
 {
-    for (auto* param : getParameters()) {
-        auto* pldParam = dynamic_cast<PlugDataParameter*>(param);
-        auto newvalue = pldParam->getUnscaledValue();
-        if (pldParam->isEnabled() && pldParam->getLastValue() != newvalue) {
-            auto title = pldParam->getTitle();
-            sendFloat(title.toRawUTF8(), pldParam->getUnscaledValue());
-            pldParam->setLastValue(newvalue);
+    auto const& parameters = getParameters();
+
+    for (int word = 0; word < dirtyParameters.size(); word++) {
+        auto dirty = dirtyParameters[word].exchange(0, std::memory_order_acquire);
+
+        while (dirty) {
+            auto const index = (word << 6) + std::countr_zero(dirty);
+            dirty &= dirty - 1;
+
+            auto* param = static_cast<PlugDataParameter*>(parameters.getUnchecked(index));
+            auto const newValue = param->getUnscaledValue();
+
+            if (!param->isEnabled() || param->getLastValue() == newValue)
+                continue;
+
+            if (auto* receiver = param->getReceiveSymbol()->s_thing) {
+                sys_lock();
+                pd_float(receiver, newValue);
+                sys_unlock();
+            }
+
+            param->setLastValue(newValue);
         }
     }
 }
@@ -748,63 +1020,129 @@ void PluginProcessor::messageEnqueued()
     }
 }
 
-void PluginProcessor::sendMidiBuffer()
-{
-    if (acceptsMidi()) {
-        for (auto const& event : midiBufferIn) {
-            auto const message = event.getMessage();
-            if (message.isNoteOn()) {
-                sendNoteOn(message.getChannel(), message.getNoteNumber(), message.getVelocity());
-            } else if (message.isNoteOff()) {
-                sendNoteOn(message.getChannel(), message.getNoteNumber(), 0);
-            } else if (message.isController()) {
-                sendControlChange(message.getChannel(), message.getControllerNumber(), message.getControllerValue());
-            } else if (message.isPitchWheel()) {
-                sendPitchBend(message.getChannel(), message.getPitchWheelValue() - 8192);
-            } else if (message.isChannelPressure()) {
-                sendAfterTouch(message.getChannel(), message.getChannelPressureValue());
-            } else if (message.isAftertouch()) {
-                sendPolyAfterTouch(message.getChannel(), message.getNoteNumber(), message.getAfterTouchValue());
-            } else if (message.isProgramChange()) {
-                sendProgramChange(message.getChannel(), message.getProgramChangeNumber());
-            } else if (message.isSysEx()) {
-                for (int i = 0; i < message.getSysExDataSize(); ++i) {
-                    sendSysEx(0, static_cast<int>(message.getSysExData()[i]));
+void PluginProcessor::sendMidiBuffer(int tickStart, bool isFirstTick, bool isLastTick)
+{
+    if (!acceptsMidi())
+        return;
+
+    int const tick = Instance::getBlockSize();
+    auto const startSample = isFirstTick ? std::numeric_limits<int>::min() : tickStart;
+    auto const endSample = isLastTick ? std::numeric_limits<int>::max() : tickStart + tick;
+
+    // The raw byte paths are only worth it when there's an object that listens to them
+    bool const hasMidiIn = midiInputSymbols.midiin.getReceiver() != nullptr;
+    bool const hasSysexIn = midiInputSymbols.sysexin.getReceiver() != nullptr;
+    bool const hasRealtimeIn = midiInputSymbols.midirealtimein.getReceiver() != nullptr;
+
+    // Decode straight from the raw data, so every event only gets parsed once
+    for (auto it = midiBufferIn.findNextSamplePosition(startSample); it != midiBufferIn.cend(); ++it) {
+        auto const event = *it;
+        if (event.samplePosition >= endSample)
+            break;
+
+        auto const* data = event.data;
+        auto const size = event.numBytes;
+        auto const status = data[0];
+
+        if (size < 1 || (status < 0xf0 && size < MidiMessage::getMessageLengthFromFirstByte(status)))
+            continue;
+
+        auto const channel = (status & 0x0f) + 1;
+        auto const offset = jlimit(0, tick - 1, event.samplePosition - tickStart);
+
+        switch (status & 0xf0) {
+        case 0x80:
+            sendNoteOn(channel, data[1], 0);
+            libpd_notein_tilde(channel, data[1], 0, offset);
+            break;
+        case 0x90:
+            sendNoteOn(channel, data[1], data[2]);
+            libpd_notein_tilde(channel, data[1], data[2], offset);
+            break;
+        case 0xa0:
+            sendPolyAfterTouch(channel, data[1], data[2]);
+            break;
+        case 0xb0:
+            sendControlChange(channel, data[1], data[2]);
+            break;
+        case 0xc0:
+            sendProgramChange(channel, data[1]);
+            break;
+        case 0xd0:
+            sendAfterTouch(channel, data[1]);
+            break;
+        case 0xe0:
+            sendPitchBend(channel, (data[1] | (data[2] << 7)) - 8192);
+            break;
+        default:
+            if (status == 0xf0 && hasSysexIn) {
+                // Leave out the start and end of sysex bytes
+                auto const sysexSize = size - (data[size - 1] == 0xf7 ? 2 : 1);
+                for (int i = 0; i < sysexSize; ++i) {
+                    sendSysEx(0, static_cast<int>(data[i + 1]));
                 }
-            } else if (message.isMidiClock() || message.isMidiStart() || message.isMidiStop() || message.isMidiContinue() || message.isActiveSense() || (message.getRawDataSize() == 1 && message.getRawData()[0] == 0xff)) {
-                for (int i = 0; i < message.getRawDataSize(); ++i) {
-                    sendSysRealTime(0, static_cast<int>(message.getRawData()[i]));
+            } else if ((status == 0xf8 || status == 0xfa || status == 0xfb || status == 0xfc || status == 0xfe || status == 0xff) && hasRealtimeIn) {
+                for (int i = 0; i < size; ++i) {
+                    sendSysRealTime(0, static_cast<int>(data[i]));
                 }
             }
+            break;
+        }
 
-            for (int i = 0; i < message.getRawDataSize(); i++) {
-                sendMidiByte(0, static_cast<int>(message.getRawData()[i]));
+        if (hasMidiIn) {
+            for (int i = 0; i < size; i++) {
+                sendMidiByte(0, static_cast<int>(data[i]));
             }
         }
-        midiBufferIn.clear();
     }
 }
 
-void PluginProcessor::processInternal()
+void PluginProcessor::processInternal(float* const* inputs, int numInputs, float* const* outputs, int numOutputs, int offset)
 {
     setThis();
 
-    // clear midi out
-    if (producesMidi()) {
-        midiByteIndex = 0;
-        midiByteBuffer[0] = 0;
-        midiByteBuffer[1] = 0;
-        midiByteBuffer[2] = 0;
-        midiBufferOut.clear();
+    // Run all Pd ticks that fit in our block, dequeueing messages before each tick
+    int const tick = Instance::getBlockSize();
+    for (int pos = offset; pos < offset + blockSize; pos += tick) {
+        // Anything Pd sends out from here on belongs to this tick
+        midiOutputTick = (pos - offset) / tick;
+        midiOutputTickTime = clock_getlogicaltime();
+
+        {
+            ScopedTrace trace(tracer, "sendMidiBuffer");
+            sendMidiBuffer(pos - offset, pos == offset, pos + tick >= offset + blockSize);
+        }
+        {
+            ScopedTrace trace(tracer, "sendMessagesFromQueue");
+            sendMessagesFromQueue();
+        }
+        {
+            ScopedTrace trace(tracer, "sendParameters");
+            sendParameters();
+        }
+        {
+            ScopedTrace trace(tracer, "sendPlayheadTick");
+            sendPlayheadTick();
+        }
+
+        ScopedTrace trace(tracer, "performDSP");
+        performDSP(inputs, numInputs, outputs, numOutputs, pos);
     }
 
-    // Dequeue messages
-    sendMessagesFromQueue();
-    sendMidiBuffer();
+    midiBufferIn.clear();
 
-    // Process audio
-    FloatVectorOperations::copy(audioBufferIn.data() + (2 * 64), audioBufferOut.data() + (2 * 64), (minOut - 2) * 64);
-    performDSP(audioBufferIn.data(), audioBufferOut.data());
+    // Move everything Pd sent out during this block into the output buffer
+    // Cleared before we let go of the lock, so MIDI that Pd sends from another thread right after isn't lost
+    midiBufferOut.clear();
+    sys_lock();
+    if (producesMidi()) {
+        midiOutputArena.forEach([this](int samplePosition, uint8 const* data, int numBytes) {
+            midiBufferOut.addEvent(data, numBytes, jlimit(0, blockSize - 1, samplePosition));
+        });
+    }
+    midiOutputArena.clear();
+    midiOutputTick = 0;
+    sys_unlock();
 }
 
 bool PluginProcessor::hasEditor() const
@@ -842,31 +1180,81 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
 
     savePatchTabPositions();
 
-    // Store pure-data and parameter state
+    // Copy the patch contents first, only holding the audio lock for one patch at a time
+    // Hashing, compressing and writing the state happens without the lock
+    std::vector<PatchState> patchStates;
+    patchStates.reserve(patches.size());
+    for (auto* patch : patches) {
+        lockAudioThread();
+        auto content = patch->getCanvasContent();
+        unlockAudioThread();
+
+        auto const hash = content.hashCode64();
+        patchStates.push_back({ std::move(content), patch->getCurrentFile(), hash });
+    }
+
     MemoryOutputStream ostream(destData, false);
 
-    ostream.writeInt(patches.size());
+    ostream.writeInt(stateMagic);
+    ostream.writeInt(stateVersion);
+    ostream.writeInt(static_cast<int>(patchStates.size()));
 
-    // Save path and content for patch
-    lockAudioThread();
-    for (auto* patch : patches) {
-        ostream.writeString(patch->getCanvasContent());
-        ostream.writeString(patch->getCurrentFile().getFullPathName());
+    // Hosts can save from several threads at once, so take the cache over while we use it
+    // A save that runs at the same time finds it empty and compresses everything itself
+    std::map<String, MemoryBlock> cachedChunks;
+    {
+        ScopedLock lock(compressedPatchCacheLock);
+        std::swap(cachedChunks, compressedPatchCache);
     }
-    unlockAudioThread();
 
-    ostream.writeInt(getLatencySamples());
-    ostream.writeInt(oversampling);
-    ostream.writeFloat(static_cast<float>(tailLength.getValue()));
+    std::map<String, MemoryBlock> usedChunks;
+    for (auto state = patchStates.begin(); state != patchStates.end(); ++state) {
+        ostream.writeInt64(state->hash);
+        ostream.writeString(state->location.getFullPathName());
+
+        // Same content as an earlier patch in this state, only store a reference to it
+        // A reference gets resolved to the first earlier patch with the same hash, so only use one if that patch really has the same content
+        auto earlier = std::find_if(patchStates.begin(), state, [&state](auto const& other) { return other.hash == state->hash; });
+        if (earlier != state && earlier->content == state->content) {
+            ostream.writeInt(0);
+            continue;
+        }
+
+        // The hash is too weak to tell patches apart on its own, so the cache goes by a digest of the content
+        // The chunk can already be there if an earlier patch with the same content couldn't be referenced
+        auto const digest = SHA256(state->content.toUTF8()).toHexString();
+        auto& chunk = usedChunks[digest];
+        if (chunk.isEmpty()) {
+            if (auto cached = cachedChunks.find(digest); cached != cachedChunks.end()) {
+                chunk = std::move(cached->second);
+            } else {
+                MemoryOutputStream chunkStream(chunk, false);
+                GZIPCompressorOutputStream compressor(chunkStream);
+                compressor.writeString(state->content);
+                compressor.flush();
+            }
+        }
+
+        ostream.writeInt(static_cast<int>(chunk.getSize()));
+        ostream.write(chunk.getData(), chunk.getSize());
+    }
+
+    // Only keep the chunks of patches that are still open
+    {
+        ScopedLock lock(compressedPatchCacheLock);
+        compressedPatchCache = std::move(usedChunks);
+    }
 
     XmlElement xml = XmlElement("plugdata_save");
     xml.setAttribute("Version", PLUGDATA_VERSION);
     xml.setAttribute("SplitIndex", lastSplitIndex);
 
-    // In the future, we're gonna load everything from xml, to make it easier to add new properties
-    // By putting this here, we can prepare for making this change without breaking existing DAW saves
     xml.setAttribute("Oversampling", oversampling);
-    xml.setAttribute("Latency", getLatencySamples());
+    xml.setAttribute("OversamplingFilter", oversamplingFilter.load());
+    xml.setAttribute("BlockSize", dspBlockSize);
+    xml.setAttribute("ZeroLatency", zeroLatencyMode.load());
+    xml.setAttribute("Latency", getBaseLatency());
+    xml.setAttribute("CustomLatency", hasCustomLatency());
     xml.setAttribute("TailLength", static_cast<float>(tailLength.getValue()));
     xml.setAttribute("Legacy", false);
 
@@ -887,19 +1275,135 @@ void PluginProcessor::getStateInformation(MemoryBlock& destData)
     ostream.write(xmlBlock.getData(), xmlBlock.getSize());
 }
 
+bool PluginProcessor::readBinaryState(MemoryInputStream& istream, std::vector<PatchState>& patchStates, std::unique_ptr<XmlElement>& xmlState)
+{
+    auto const version = istream.readInt();
+
+    // Saved by a newer version of plugdata
+    if (version > stateVersion)
+        return false;
+
+    auto const numPatches = istream.readInt();
+    for (int i = 0; i < numPatches && !istream.isExhausted(); i++) {
+        auto const hash = istream.readInt64();
+        auto location = File(istream.readString());
+        auto const chunkSize = istream.readInt();
+
+        if (chunkSize < 0 || chunkSize > istream.getNumBytesRemaining())
+            return false;
+
+        if (chunkSize == 0) {
+            auto earlier = std::find_if(patchStates.begin(), patchStates.end(), [hash](auto const& state) { return state.hash == hash; });
+            if (earlier == patchStates.end())
+                return false;
+
+            patchStates.push_back({ earlier->content, location, hash });
+            continue;
+        }
+
+        GZIPDecompressorInputStream decompressor(new MemoryInputStream(static_cast<char const*>(istream.getData()) + istream.getPosition(), static_cast<size_t>(chunkSize), false), true);
+        patchStates.push_back({ decompressor.readString(), location, hash });
+
+        istream.skipNextBytes(chunkSize);
+    }
+
+    auto const xmlSize = istream.readInt();
+    if (xmlSize <= 0 || xmlSize > istream.getNumBytesRemaining())
+        return false;
+
+    xmlState = getXmlFromBinary(static_cast<char const*>(istream.getData()) + istream.getPosition(), xmlSize);
+    return xmlState != nullptr;
+}
+
+// Reads the format that plugdata used before the state was versioned: plain text patches, followed by a few values and the xml
+bool PluginProcessor::readLegacyState(MemoryInputStream& istream, std::vector<PatchState>& patchStates, std::unique_ptr<XmlElement>& xmlState)
+{
+    int numPatches = istream.readInt();
+
+    for (int i = 0; i < numPatches; i++) {
+        auto content = istream.readString();
+        auto location = File(istream.readString());
+        auto const hash = content.hashCode64();
+        patchStates.push_back({ std::move(content), location, hash });
+    }
+
+    auto latency = istream.readInt();
+    auto oversampling = istream.readInt();
+    auto tail = istream.readFloat();
+    auto xmlSize = istream.readInt();
+
+    if (xmlSize <= 0 || xmlSize > istream.getNumBytesRemaining())
+        return false;
+
+    xmlState = getXmlFromBinary(static_cast<char const*>(istream.getData()) + istream.getPosition(), xmlSize);
+
+    jassert(xmlState);
+
+    if (!xmlState)
+        return false;
+
+    // Older versions only stored these outside of the xml
+    xmlState->setAttribute("Latency", latency);
+    xmlState->setAttribute("Oversampling", oversampling);
+    xmlState->setAttribute("TailLength", tail);
+
+    return true;
+}
+
+bool PluginProcessor::patchesMatchState(std::vector<PatchState> const& patchStates)
+{
+    if (static_cast<int>(patchStates.size()) != patches.size())
+        return false;
+
+    for (int i = 0; i < patches.size(); i++) {
+        auto const& state = patchStates[i];
+
+        // Patches from the temp directory are loaded as untitled, see setStateInformation
+        auto const isUntitled = !state.location.existsAsFile() || state.location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory);
+        if (patches[i]->getCurrentFile() != (isUntitled ? File() : state.location))
+            return false;
+
+        lockAudioThread();
+        auto const content = patches[i]->getCanvasContent();
+        unlockAudioThread();
+
+        if (content != state.content)
+            return false;
+    }
+
+    return true;
+}
+
 void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
 {
     if (sizeInBytes == 0)
         return;
 
+    MemoryInputStream istream(data, sizeInBytes, false);
+
+    std::vector<PatchState> patchStates;
+    std::unique_ptr<XmlElement> xmlState;
+
+    auto const isBinaryState = istream.readInt() == stateMagic;
+    if (!isBinaryState)
+        istream.setPosition(0);
+
+    if (!(isBinaryState ? readBinaryState(istream, patchStates, xmlState) : readLegacyState(istream, patchStates, xmlState))) {
+        logError("Couldn't read plugin state");
+        return;
+    }
+
     // By calling this asynchronously on the message thread and also suspending processing on the audio thread, we can make sure this is safe
     // The DAW can call this function from basically any thread, hence the need for this
     // Audio will only be reactivated once this action is completed
 
-    MemoryInputStream istream(data, sizeInBytes, false);
+    setThis();
+
+    // Hosts often set the same state that we're already in, in that case there is no need to reload the patches
+    auto const reloadPatches = !patchesMatchState(patchStates);
 
     // Close any opened patches
-    if (auto* editor = dynamic_cast<PluginEditor*>(getActiveEditor())) {
+    if (auto* editor = dynamic_cast<PluginEditor*>(getActiveEditor()); editor && reloadPatches) {
         MessageManager::callAsync([editor = Component::SafePointer(editor)]() {
             if (!editor)
                 return;
@@ -911,81 +1415,74 @@ void PluginProcessor::setStateInformation(void const* data, int sizeInBytes)
     }
 
     suspendProcessing(true);
-    setThis();
-    patches.clear();
 
-    int numPatches = istream.readInt();
+    if (reloadPatches) {
+        patches.clear();
 
-    for (int i = 0; i < numPatches; i++) {
-        auto state = istream.readString();
-        auto location = File(istream.readString());
+        for (auto const& state : patchStates) {
+            auto const& location = state.location;
 
-        if (location.getParentDirectory().exists()) {
-            auto parentPath = location.getParentDirectory().getFullPathName();
-            // Add patch path to search path to make sure it finds abstractions in the saved patch!
-            // TODO: is there any way to make this local the the canvas?
-            libpd_add_to_search_path(parentPath.toRawUTF8());
-        }
+            if (location.getParentDirectory().exists()) {
+                auto parentPath = location.getParentDirectory().getFullPathName();
+                // Add patch path to search path to make sure it finds abstractions in the saved patch!
+                // TODO: is there any way to make this local the the canvas?
+                libpd_add_to_search_path(parentPath.toRawUTF8());
+            }
 
-        auto* patch = loadPatch(state);
+            auto* patch = loadPatch(state.content);
 
-        if ((location.exists() && location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) || !location.exists()) {
-            patch->setTitle("Untitled Patcher");
-        } else if (location.existsAsFile()) {
-            patch->setCurrentFile(location);
-            patch->setTitle(location.getFileName());
+            if ((location.exists() && location.getParentDirectory() == File::getSpecialLocation(File::tempDirectory)) || !location.exists()) {
+                patch->setTitle("Untitled Patcher");
+            } else if (location.existsAsFile()) {
+                patch->setCurrentFile(location);
+                patch->setTitle(location.getFileName());
+            }
         }
     }
 
-    auto latency = istream.readInt();
-    auto oversampling = istream.readInt();
-    auto tail = istream.readFloat();
-    auto xmlSize = istream.readInt();
-
-    tailLength = var(tail);
+    // States from before the base latency was separate from the oversampling latency only stored what the user set
+    auto latency = xmlState->getBoolAttribute("CustomLatency", true) ? xmlState->getIntAttribute("Latency", -1) : -1;
+    auto oversampling = xmlState->getIntAttribute("Oversampling", 0);
 
-    auto* xmlData = new char[xmlSize];
-    istream.read(xmlData, xmlSize);
+    tailLength = var(xmlState->getDoubleAttribute("TailLength", 0.0));
 
-    std::unique_ptr<XmlElement> xmlState(getXmlFromBinary(xmlData, xmlSize));
+    PlugDataParameter::loadStateInformation(*xmlState, getParameters());
 
-    jassert(xmlState);
-
-    if (xmlState) {
-        PlugDataParameter::loadStateInformation(*xmlState, getParameters());
+    auto versionString = String("0.6.1"); // latest version that didn't have version inside the daw state
 
-        auto versionString = String("0.6.1"); // latest version that didn't have version inside the daw state
+    if (xmlState->hasAttribute("Version")) {
+        versionString = xmlState->getStringAttribute("Version");
+    }
 
-        if (xmlState->hasAttribute("Version")) {
-            versionString = xmlState->getStringAttribute("Version");
+    if (xmlState->hasAttribute("Height") && xmlState->hasAttribute("Width")) {
+        int windowWidth = xmlState->getIntAttribute("Width", 1000);
+        int windowHeight = xmlState->getIntAttribute("Height", 650);
+        lastUIWidth = windowWidth;
+        lastUIHeight = windowHeight;
+        if (auto* editor = getActiveEditor()) {
+            MessageManager::callAsync([editor = Component::SafePointer(editor), windowWidth, windowHeight]() {
+                if (!editor)
+                    return;
+                editor->setSize(windowWidth, windowHeight);
+            });
         }
+    }
+    // These re-prepare if they changed, processing is still suspended so that won't resume the audio early
+    setDSPBlockSize(xmlState->getIntAttribute("BlockSize", Instance::getBlockSize()));
+    setZeroLatencyMode(xmlState->getBoolAttribute("ZeroLatency", false));
+    oversamplingFilter = xmlState->getIntAttribute("OversamplingFilter", MinimumPhaseIIR);
 
-        if (xmlState->hasAttribute("Height") && xmlState->hasAttribute("Width")) {
-            int windowWidth = xmlState->getIntAttribute("Width", 1000);
-            int windowHeight = xmlState->getIntAttribute("Height", 650);
-            lastUIWidth = windowWidth;
-            lastUIHeight = windowHeight;
-            if (auto* editor = getActiveEditor()) {
-                MessageManager::callAsync([editor = Component::SafePointer(editor), windowWidth, windowHeight]() {
-                    if (!editor)
-                        return;
-                    editor->setSize(windowWidth, windowHeight);
-                });
-            }
-        }
-        if (xmlState->hasAttribute("SplitIndex")) {
+    if (xmlState->hasAttribute("SplitIndex") && reloadPatches) {
 
-            lastSplitIndex = xmlState->getIntAttribute("SplitIndex", -1);
+        lastSplitIndex = xmlState->getIntAttribute("SplitIndex", -1);
 
-            if (auto* editor = dynamic_cast<PluginEditor*>(getActiveEditor())) {
-                editor->splitView.splitCanvasesAfterIndex(lastSplitIndex, true);
-            }
+        if (auto* editor = dynamic_cast<PluginEditor*>(getActiveEditor())) {
+            editor->splitView.splitCanvasesAfterIndex(lastSplitIndex, true);
         }
     }
 
-    setLatencySamples(latency);
     setOversampling(oversampling);
-    delete[] xmlData;
+    setBaseLatency(latency);
 
     suspendProcessing(false);
 
@@ -1023,6 +1520,9 @@ pd::Patch* PluginProcessor::loadPatch(File const& patchFile)
         }
     }
 
+    // Read the file before stopping the audio callback, only creating the patch has to happen while it's stopped
+    patchCache.getContent(patchFile);
+
     // Stop the audio callback when loading a new patch
     suspendProcessing(true);
 
@@ -1058,6 +1558,7 @@ pd::Patch* PluginProcessor::loadPatch(String patchText)
 
     auto patchFile = File::createTempFile(".pd");
     patchFile.replaceWithText(patchText);
+    patchCache.setContent(patchFile, patchText);
 
     auto* patch = loadPatch(patchFile);
 
@@ -1109,59 +1610,79 @@ Colour PluginProcessor::getTextColour()
     return lnf->findColour(PlugDataColour::toolbarTextColourId);
 }
 
-void PluginProcessor::receiveNoteOn(int const channel, int const pitch, int const velocity)
+int PluginProcessor::getMidiOutputPosition() const
 {
-    if (velocity == 0) {
-        midiBufferOut.addEvent(MidiMessage::noteOff(channel, pitch, uint8(0)), audioAdvancement);
-    } else {
-        midiBufferOut.addEvent(MidiMessage::noteOn(channel, pitch, static_cast<uint8>(velocity)), audioAdvancement);
+    int const tick = Instance::getBlockSize();
+
+    // Messages that come from clocks are sent while Pd's logical time is somewhere within the tick
+    auto const pdSampleRate = AudioProcessor::getSampleRate() * (1 << activeOversampling);
+    auto const offset = static_cast<int>(clock_gettimesince(midiOutputTickTime) * pdSampleRate / 1000.0);
+
+    return midiOutputTick * tick + jlimit(0, tick - 1, offset);
+}
+
+void PluginProcessor::addMidiOutput(std::initializer_list<int> bytes)
+{
+    uint8 data[3];
+    int size = 0;
+    for (auto const byte : bytes) {
+        data[size++] = static_cast<uint8>(byte);
     }
+
+    midiOutputArena.add(getMidiOutputPosition(), data, size);
+}
+
+void PluginProcessor::receiveNoteOn(int const channel, int const pitch, int const velocity)
+{
+    auto const status = velocity == 0 ? 0x80 : 0x90;
+    addMidiOutput({ status | ((channel - 1) & 0x0f), pitch & 0x7f, velocity & 0x7f });
 }
 
 void PluginProcessor::receiveControlChange(int const channel, int const controller, int const value)
 {
-    midiBufferOut.addEvent(MidiMessage::controllerEvent(channel, controller, value), audioAdvancement);
+    addMidiOutput({ 0xb0 | ((channel - 1) & 0x0f), controller & 0x7f, value & 0x7f });
 }
 
 void PluginProcessor::receiveProgramChange(int const channel, int const value)
 {
-    midiBufferOut.addEvent(MidiMessage::programChange(channel, value), audioAdvancement);
+    addMidiOutput({ 0xc0 | ((channel - 1) & 0x0f), value & 0x7f });
 }
 
 void PluginProcessor::receivePitchBend(int const channel, int const value)
 {
-    midiBufferOut.addEvent(MidiMessage::pitchWheel(channel, value + 8192), audioAdvancement);
+    auto const bend = jlimit(0, 0x3fff, value + 8192);
+    addMidiOutput({ 0xe0 | ((channel - 1) & 0x0f), bend & 0x7f, bend >> 7 });
 }
 
 void PluginProcessor::receiveAftertouch(int const channel, int const value)
 {
-    midiBufferOut.addEvent(MidiMessage::channelPressureChange(channel, value), audioAdvancement);
+    addMidiOutput({ 0xd0 | ((channel - 1) & 0x0f), value & 0x7f });
 }
 
 void PluginProcessor::receivePolyAftertouch(int const channel, int const pitch, int const value)
 {
-    midiBufferOut.addEvent(MidiMessage::aftertouchChange(channel, pitch, value), audioAdvancement);
+    addMidiOutput({ 0xa0 | ((channel - 1) & 0x0f), pitch & 0x7f, value & 0x7f });
 }
 
 void PluginProcessor::receiveMidiByte(int const port, int const byte)
 {
     if (midiByteIsSysex) {
+        midiByteBuffer[midiByteIndex++] = static_cast<uint8>(byte);
         if (byte == 0xf7) {
-            midiBufferOut.addEvent(MidiMessage::createSysExMessage(midiByteBuffer, static_cast<int>(midiByteIndex)), audioAdvancement);
+            midiOutputArena.add(getMidiOutputPosition(), midiByteBuffer, static_cast<int>(midiByteIndex));
             midiByteIndex = 0;
             midiByteIsSysex = false;
-        } else {
-            midiByteBuffer[midiByteIndex++] = static_cast<uint8>(byte);
-            if (midiByteIndex == 512) {
-                midiByteIndex = 511;
-            }
+        } else if (midiByteIndex == std::size(midiByteBuffer) - 1) {
+            // Keep room for the end of sysex byte
+            midiByteIndex--;
         }
     } else if (midiByteIndex == 0 && byte == 0xf0) {
+        midiByteBuffer[midiByteIndex++] = static_cast<uint8>(byte);
         midiByteIsSysex = true;
     } else {
         midiByteBuffer[midiByteIndex++] = static_cast<uint8>(byte);
         if (midiByteIndex >= 3) {
-            midiBufferOut.addEvent(MidiMessage(midiByteBuffer, 3), audioAdvancement);
+            midiOutputArena.add(getMidiOutputPosition(), midiByteBuffer, 3);
             midiByteIndex = 0;
         }
     }
@@ -12,6 +12,13 @@
 #include "Pd/PdLibrary.h"
 #include "Utility/SettingsFile.h"
 #include "Statusbar.h"
+#include "Utility/Tracer.h"
+#include "Utility/MidiOutputArena.h"
+
+extern "C" {
+#include "x_libpd_playhead.h"
+#include "x_libpd_notein_tilde.h"
+}
 
 #if PLUGDATA_STANDALONE
 #    include "Utility/InternalSynth.h"
@@ -29,7 +36,16 @@ public:
     static AudioProcessor::BusesProperties buildBusesProperties();
 
     void setOversampling(int amount);
+    void setOversamplingFilter(int filter);
+    void setDSPBlockSize(int blockSize);
+    void setZeroLatencyMode(bool enabled);
     void setProtectedMode(bool enabled);
+
+    // Latency before the oversampling filters, either set by the user or our own buffering latency
+    // The latency of the oversampling filters always gets added on top of this. Pass -1 to go back to our own buffering latency
+    void setBaseLatency(int samples);
+    int getBaseLatency() const;
+    bool hasCustomLatency() const { return customLatency >= 0; }
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
@@ -66,6 +82,10 @@ public:
     void receivePolyAftertouch(int const channel, int const pitch, int const value) override;
     void receiveMidiByte(int const port, int const byte) override;
 
+    // Sample position within the current block for MIDI that Pd sends out right now
+    int getMidiOutputPosition() const;
+    void addMidiOutput(std::initializer_list<int> bytes);
+
     void receiveDSPState(bool dsp) override;
     void updateDrawables() override;
 
@@ -91,10 +111,22 @@ public:
     void initialiseFilesystem();
     void updateSearchPaths();
 
-    void sendMidiBuffer();
-    void sendPlayhead();
+    // Sends the MIDI input events for the tick that starts at tickStart to Pd
+    // The first and last tick of a block also take any events that lie before or after the block
+    void sendMidiBuffer(int tickStart, bool isFirstTick, bool isLastTick);
+    // Reads the host playhead once per block, and works out which fields changed since the previous block
+    void updatePlayhead();
+    // Sends the changed fields, and the position for the tick that's about to run, to [playhead] and the playhead receiver
+    void sendPlayheadTick();
     void sendParameters();
 
+    // Called by PlugDataParameter whenever its value changes, from any thread
+    void markParameterDirty(int index)
+    {
+        if (isPositiveAndBelow(index, numParameters + 1))
+            dirtyParameters[index >> 6].fetch_or(uint64(1) << (index & 63), std::memory_order_release);
+    }
+
     void messageEnqueued() override;
     void performParameterChange(int type, String name, float value) override;
 
@@ -133,6 +165,9 @@ public:
 
     StatusbarSource statusbarSource;
 
+    // Timing of the audio engine stages, shown in the performance panel
+    Tracer tracer;
+
     Value tailLength = Value(0.0f);
 
     // Just so we never have to deal with deleting the default LnF
@@ -147,6 +182,21 @@ public:
 
     // Zero means no oversampling
     std::atomic<int> oversampling = 0;
+
+    enum OversamplingFilter {
+        MinimumPhaseIIR = 0, // Lowest latency
+        LinearPhaseFIR       // No phase distortion, at the cost of more latency
+    };
+    std::atomic<int> oversamplingFilter = MinimumPhaseIIR;
+
+    // Number of samples we process at once, always a multiple of Pd's block size
+    std::atomic<int> dspBlockSize = 64;
+
+    // Process directly on the host buffers, without the extra block of latency, if the host block size allows it
+    std::atomic<bool> zeroLatencyMode = false;
+
+    // Set when zero latency mode is on, but the host block size forced us back to buffering
+    std::atomic<bool> zeroLatencyFallback = false;
     int lastLeftTab = -1;
     int lastRightTab = -1;
 
@@ -158,30 +208,137 @@ public:
 #endif
 
 private:
-    void processInternal();
+    void processInternal(float* const* inputs, int numInputs, float* const* outputs, int numOutputs, int offset);
 
     int audioAdvancement = 0;
+    int blockSize = 64;
+    bool zeroLatencyActive = false;
+    int activeOversampling = 0; // Oversampling that's currently running, only changed with the callback lock held
+
+    // One bit per parameter (including volume), so sendParameters only has to visit the ones that changed
+    std::array<std::atomic<uint64>, (numParameters + 64) / 64> dirtyParameters = {};
+
     std::vector<float> audioBufferIn;
     std::vector<float> audioBufferOut;
+    std::vector<float*> audioChannelsIn;
+    std::vector<float*> audioChannelsOut;
 
     MidiBuffer midiBufferIn;
     MidiBuffer midiBufferOut;
     MidiBuffer midiBufferTemp;
     MidiBuffer midiBufferCopy;
 
+    MidiOutputArena midiOutputArena;
+    int midiOutputTick = 0;           // Index of the current tick within the block
+    double midiOutputTickTime = 0.0;  // Pd's logical time at the start of the current tick
+
     bool midiByteIsSysex = false;
     uint8 midiByteBuffer[512] = { 0 };
     size_t midiByteIndex = 0;
 
     std::vector<pd::Atom> atoms_playhead;
 
-    int minIn = 2;
-    int minOut = 2;
+    t_libpd_playhead_state playheadState = {};
+    int playheadChanges = LIBPD_PLAYHEAD_ALL;
+    int playheadTickOffset = 0; // Host samples since the start of the current block
+    bool hasPlayhead = false;
+
+    // Resolved once in the constructor, the playhead gets sent for every tick
+    struct PlayheadSymbols {
+        pd::SymbolHandle receiver;
+        pd::SymbolHandle playing;
+        pd::SymbolHandle recording;
+        pd::SymbolHandle looping;
+        pd::SymbolHandle edittime;
+        pd::SymbolHandle framerate;
+        pd::SymbolHandle bpm;
+        pd::SymbolHandle lastbar;
+        pd::SymbolHandle timesig;
+        pd::SymbolHandle position;
+    } playheadSymbols;
+
+    // Objects that want raw MIDI bytes bind to these
+    struct MidiInputSymbols {
+        pd::SymbolHandle midiin;
+        pd::SymbolHandle sysexin;
+        pd::SymbolHandle midirealtimein;
+    } midiInputSymbols;
 
     int lastSplitIndex = -1;
 
     std::unique_ptr<dsp::Oversampling<float>> oversampler;
 
+    // Hands a new oversampler to the audio thread, which fades out, swaps it in and fades back in
+    void updateOversampling();
+    void switchOversampler();
+    std::unique_ptr<dsp::Oversampling<float>> createOversampler(int amount, int filter, int samplesPerBlock) const;
+    void updateLatency();
+
+    struct OversamplerSwitch {
+        std::unique_ptr<dsp::Oversampling<float>> oversampler;
+        int amount;
+    };
+
+    // Created on the message thread, taken by the audio thread once it faded out
+    std::atomic<OversamplerSwitch*> pendingOversampler = nullptr;
+
+    // The oversampler that got replaced, freed on the message thread. Only touched with the callback lock held
+    std::unique_ptr<OversamplerSwitch> retiredOversampler;
+
+    // Oversampling settings that are running or waiting to be swapped in, so we only switch when they change
+    std::atomic<int> requestedOversampling = -1;
+    std::atomic<int> requestedOversamplingFilter = -1;
+
+    // Prepares again with the current host settings, so changes to the block size or zero latency mode take effect
+    void reprepare();
+
+    // Reports the new latency from the message thread, when the audio thread finds it has to fall back to buffering
+    // or swapped in a new oversampler, and frees the oversampler that it replaced
+    struct LatencyUpdater : public AsyncUpdater {
+        explicit LatencyUpdater(PluginProcessor& p)
+            : processor(p)
+        {
+        }
+
+        void handleAsyncUpdate() override
+        {
+            // Freed after we let go of the lock
+            std::unique_ptr<OversamplerSwitch> retired;
+            {
+                ScopedLock lock(processor.getCallbackLock());
+                processor.updateLatency();
+                retired = std::move(processor.retiredOversampler);
+            }
+        }
+
+        PluginProcessor& processor;
+    };
+
+    LatencyUpdater latencyUpdater { *this };
+
+    std::atomic<int> customLatency = -1;
+
+    LinearSmoothedValue<float> switchGain = 1.0f;
+
+    // DAW state: a version header, then one gzipped chunk per patch, keyed by a hash of the patch content
+    static constexpr int stateMagic = 0x50445354; // "PDST", legacy states start with a small patch count instead
+    static constexpr int stateVersion = 1;
+
+    struct PatchState {
+        String content;
+        File location;
+        int64 hash;
+    };
+
+    static bool readBinaryState(MemoryInputStream& istream, std::vector<PatchState>& patchStates, std::unique_ptr<XmlElement>& xmlState);
+    static bool readLegacyState(MemoryInputStream& istream, std::vector<PatchState>& patchStates, std::unique_ptr<XmlElement>& xmlState);
+    bool patchesMatchState(std::vector<PatchState> const& patchStates);
+
+    // Compressed chunks of the last save, so unchanged patches don't get compressed again on every autosave
+    // Keyed by the SHA-256 of the patch content
+    std::map<String, MemoryBlock> compressedPatchCache;
+    CriticalSection compressedPatchCacheLock;
+
     static inline const String else_version = "ELSE v1.0-rc7";
     static inline const String cyclone_version = "cyclone v0.7-0";
     // this gets updated with live version data later
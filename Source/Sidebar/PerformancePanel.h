@@ -0,0 +1,333 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+
+#include "Utility/Tracer.h"
+
+bool wantsNativeDialog();
+
+// Shows how much time each stage of the audio engine takes, based on the events recorded by the processor's tracer
+// In object mode, it shows the DSP cost of every object instead, and colours the objects in the canvas by their cost
+class PerformancePanel : public Component
+    , public Timer {
+
+    struct StageStatistics {
+        String name;
+        int numCalls = 0;
+        double totalTime = 0.0; // In microseconds
+        double maxTime = 0.0;
+    };
+
+    enum SortColumn {
+        SortByName,
+        SortByTime
+    };
+
+public:
+    PerformancePanel(PluginProcessor* processor, PluginEditor* pluginEditor)
+        : pd(processor)
+        , editor(pluginEditor)
+    {
+        std::vector<String> tooltips = { "Enable tracing", "Show DSP cost per object", "Clear recorded events", "Export as Chrome trace" };
+
+        std::vector<std::function<void()>> callbacks = {
+            [this]() { setTracingEnabled(buttons[0].getToggleState()); },
+            [this]() { setShowObjects(buttons[1].getToggleState()); },
+            [this]() { clear(); },
+            [this]() { exportTrace(); },
+        };
+
+        for (int i = 0; i < buttons.size(); i++) {
+            auto& button = buttons[i];
+            button.getProperties().set("Style", "SmallIcon");
+            button.setConnectedEdges(12);
+            button.onClick = callbacks[i];
+            button.setTooltip(tooltips[i]);
+            addAndMakeVisible(button);
+        }
+
+        buttons[0].setClickingTogglesState(true);
+        buttons[0].setToggleState(pd->tracer.isEnabled(), dontSendNotification);
+        buttons[1].setClickingTogglesState(true);
+
+        if (pd->tracer.isEnabled())
+            startTimer(250);
+    }
+
+    ~PerformancePanel() override
+    {
+        // Don't leave the audio thread doing work for nobody
+        pd->tracer.setEnabled(false);
+        pd->setDSPProfilingInterval(0);
+        clearHeatmap();
+    }
+
+    void setTracingEnabled(bool enabled)
+    {
+        pd->tracer.setEnabled(enabled);
+        pd->setDSPProfilingInterval(enabled && showObjects ? profilingInterval : 0);
+
+        if (enabled) {
+            startTimer(250);
+        } else {
+            stopTimer();
+        }
+    }
+
+    void setShowObjects(bool shouldShowObjects)
+    {
+        showObjects = shouldShowObjects;
+        pd->setDSPProfilingInterval(pd->tracer.isEnabled() && showObjects ? profilingInterval : 0);
+
+        if (!showObjects) {
+            objectStatistics.clear();
+            clearHeatmap();
+        }
+
+        repaint();
+    }
+
+    void clear()
+    {
+        history.clear();
+        statistics.clear();
+        objectStatistics.clear();
+        clearHeatmap();
+        repaint();
+    }
+
+    void exportTrace()
+    {
+        saveChooser = std::make_unique<FileChooser>("Export trace", File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("plugdata_trace.json"), "*.json", wantsNativeDialog());
+
+        saveChooser->launchAsync(FileBrowserComponent::saveMode | FileBrowserComponent::warnAboutOverwriting,
+            [this](FileChooser const& f) {
+                auto result = f.getResult();
+                if (result.getFullPathName().isEmpty())
+                    return;
+
+                result.withFileExtension(".json").replaceWithText(Tracer::toChromeTrace(history, pd->tracer));
+            });
+    }
+
+    void timerCallback() override
+    {
+        pd->tracer.collect(history);
+
+        // Keep a limited amount of history around for exporting
+        if (history.size() > maxHistorySize) {
+            history.erase(history.begin(), history.begin() + static_cast<long>(history.size() - maxHistorySize));
+        }
+
+        updateStatistics();
+
+        if (showObjects) {
+            updateObjectStatistics();
+        }
+
+        repaint();
+    }
+
+    void updateObjectStatistics()
+    {
+        objectStatistics = pd->getDSPProfile();
+        sortObjectStatistics();
+
+        std::unordered_map<void*, double> times;
+        for (auto const& entry : objectStatistics) {
+            times[entry.object] = entry.time;
+        }
+
+        // Colour every object relative to the most expensive object in the same patch
+        for (auto* cnv : editor->canvases) {
+            double maxTime = 0.0;
+            for (auto* object : cnv->objects) {
+                if (auto it = times.find(object->getPointer()); it != times.end())
+                    maxTime = std::max(maxTime, it->second);
+            }
+
+            for (auto* object : cnv->objects) {
+                auto it = times.find(object->getPointer());
+                object->setDSPLoad(it != times.end() && maxTime > 0.0 ? static_cast<float>(it->second / maxTime) : 0.0f);
+            }
+        }
+    }
+
+    void sortObjectStatistics()
+    {
+        std::sort(objectStatistics.begin(), objectStatistics.end(), [this](auto const& a, auto const& b) {
+            if (sortColumn == SortByName) {
+                auto const compare = a.text.compareNatural(b.text);
+                return sortAscending ? compare < 0 : compare > 0;
+            }
+
+            return sortAscending ? a.time < b.time : a.time > b.time;
+        });
+    }
+
+    void clearHeatmap()
+    {
+        for (auto* cnv : editor->canvases) {
+            for (auto* object : cnv->objects) {
+                object->setDSPLoad(0.0f);
+            }
+        }
+    }
+
+    void mouseUp(MouseEvent const& e) override
+    {
+        if (!showObjects || e.y > rowHeight + 4)
+            return;
+
+        // Clicking a column header sorts by that column, clicking it again reverses the order
+        auto const column = e.x < (getWidth() - 12) / 2 ? SortByName : SortByTime;
+        sortAscending = column == sortColumn ? !sortAscending : column == SortByName;
+        sortColumn = column;
+
+        sortObjectStatistics();
+        repaint();
+    }
+
+    void updateStatistics()
+    {
+        statistics.clear();
+
+        if (history.empty())
+            return;
+
+        // Only look at the last second
+        auto const now = history.back().end;
+        auto const windowStart = now - Time::secondsToHighResolutionTicks(1.0);
+
+        for (auto it = history.rbegin(); it != history.rend() && it->end >= windowStart; ++it) {
+            auto const duration = Time::highResolutionTicksToSeconds(it->end - it->start) * 1e6;
+
+            auto stage = std::find_if(statistics.begin(), statistics.end(), [name = it->name](auto const& s) { return s.name == name; });
+            if (stage == statistics.end()) {
+                statistics.push_back({ it->name });
+                stage = statistics.end() - 1;
+            }
+
+            stage->numCalls++;
+            stage->totalTime += duration;
+            stage->maxTime = std::max(stage->maxTime, duration);
+        }
+
+        std::sort(statistics.begin(), statistics.end(), [](auto const& a, auto const& b) { return a.totalTime > b.totalTime; });
+    }
+
+    void paint(Graphics& g) override
+    {
+        auto bounds = getLocalBounds().withTrimmedBottom(30).reduced(6, 4);
+
+        auto textColour = findColour(PlugDataColour::sidebarTextColourId);
+
+        if (!pd->tracer.isEnabled() && statistics.empty() && objectStatistics.empty()) {
+            PlugDataLook::drawText(g, "Enable tracing to measure the audio engine", bounds.removeFromTop(rowHeight), textColour.withAlpha(0.5f), 14, Justification::centred);
+            return;
+        }
+
+        // Happens when more threads record than the tracer has room for
+        if (auto const numDropped = pd->tracer.getNumDroppedEvents()) {
+            PlugDataLook::drawText(g, String(numDropped) + " events dropped", bounds.removeFromBottom(rowHeight), textColour.withAlpha(0.5f), 14, Justification::centredLeft);
+        }
+
+        if (showObjects) {
+            paintObjectStatistics(g, bounds, textColour);
+            return;
+        }
+
+        auto header = bounds.removeFromTop(rowHeight);
+        auto const columnWidth = header.getWidth() / 6;
+        PlugDataLook::drawStyledText(g, "Stage", header.removeFromLeft(columnWidth * 3), textColour, Semibold, 14);
+        PlugDataLook::drawStyledText(g, String(CharPointer_UTF8("Avg \xc2\xb5s")), header.removeFromLeft(columnWidth), textColour, Semibold, 14, Justification::centredRight);
+        PlugDataLook::drawStyledText(g, String(CharPointer_UTF8("Max \xc2\xb5s")), header.removeFromLeft(columnWidth), textColour, Semibold, 14, Justification::centredRight);
+        PlugDataLook::drawStyledText(g, "CPU", header, textColour, Semibold, 14, Justification::centredRight);
+
+        for (auto const& stage : statistics) {
+            if (bounds.getHeight() < rowHeight)
+                break;
+
+            auto row = bounds.removeFromTop(rowHeight);
+
+            // Percentage of wall clock time spent in this stage, over the last second
+            auto const load = stage.totalTime / 1e6;
+
+            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+            g.fillRoundedRectangle(row.withWidth(static_cast<int>(row.getWidth() * std::min(load, 1.0))).reduced(0, 2).toFloat(), PlugDataLook::smallCornerRadius);
+
+            PlugDataLook::drawText(g, stage.name, row.removeFromLeft(columnWidth * 3), textColour, 14);
+            PlugDataLook::drawText(g, String(stage.totalTime / stage.numCalls, 1), row.removeFromLeft(columnWidth), textColour, 14, Justification::centredRight);
+            PlugDataLook::drawText(g, String(stage.maxTime, 1), row.removeFromLeft(columnWidth), textColour, 14, Justification::centredRight);
+            PlugDataLook::drawText(g, String(load * 100.0, 1) + "%", row, textColour, 14, Justification::centredRight);
+        }
+    }
+
+    void paintObjectStatistics(Graphics& g, Rectangle<int> bounds, Colour textColour)
+    {
+        auto header = bounds.removeFromTop(rowHeight);
+        auto const columnWidth = header.getWidth() / 4;
+
+        auto const arrow = String(CharPointer_UTF8(sortAscending ? " \xe2\x96\xb4" : " \xe2\x96\xbe"));
+        PlugDataLook::drawStyledText(g, sortColumn == SortByName ? "Object" + arrow : "Object", header.removeFromLeft(columnWidth * 2), textColour, Semibold, 14);
+        PlugDataLook::drawStyledText(g, String(CharPointer_UTF8("Avg \xc2\xb5s")) + (sortColumn == SortByTime ? arrow : ""), header.removeFromLeft(columnWidth), textColour, Semibold, 14, Justification::centredRight);
+        PlugDataLook::drawStyledText(g, "CPU", header, textColour, Semibold, 14, Justification::centredRight);
+
+        // Time that's available for a single Pd tick
+        auto const tickDuration = pd->getSampleRate() > 0.0 ? pd->pd::Instance::getBlockSize() / pd->getSampleRate() : 0.0;
+
+        for (auto const& entry : objectStatistics) {
+            if (bounds.getHeight() < rowHeight)
+                break;
+
+            auto row = bounds.removeFromTop(rowHeight);
+            auto const load = tickDuration > 0.0 ? entry.time / tickDuration : 0.0;
+
+            g.setColour(findColour(PlugDataColour::sidebarActiveBackgroundColourId));
+            g.fillRoundedRectangle(row.withWidth(static_cast<int>(row.getWidth() * std::min(load, 1.0))).reduced(0, 2).toFloat(), PlugDataLook::smallCornerRadius);
+
+            auto const colour = entry.object ? textColour : textColour.withAlpha(0.5f);
+            PlugDataLook::drawText(g, entry.text, row.removeFromLeft(columnWidth * 2), colour, 14);
+            PlugDataLook::drawText(g, String(entry.time * 1e6, 2), row.removeFromLeft(columnWidth), colour, 14, Justification::centredRight);
+            PlugDataLook::drawText(g, String(load * 100.0, 1) + "%", row, colour, 14, Justification::centredRight);
+        }
+    }
+
+    void resized() override
+    {
+        auto fb = FlexBox(FlexBox::Direction::row, FlexBox::Wrap::noWrap, FlexBox::AlignContent::flexStart, FlexBox::AlignItems::stretch, FlexBox::JustifyContent::flexStart);
+
+        for (auto& b : buttons) {
+            auto item = FlexItem(b).withMinWidth(8.0f).withMinHeight(8.0f).withMaxHeight(27);
+            item.flexGrow = 1.0f;
+            item.flexShrink = 1.0f;
+            fb.items.add(item);
+        }
+
+        fb.performLayout(getLocalBounds().toFloat().removeFromBottom(30));
+    }
+
+private:
+    static constexpr int rowHeight = 24;
+    static constexpr size_t maxHistorySize = 1 << 20;
+    static constexpr int profilingInterval = 16; // Profile one out of every 16 Pd ticks
+
+    PluginProcessor* pd;
+    PluginEditor* editor;
+
+    std::vector<Tracer::Event> history;
+    std::vector<StageStatistics> statistics;
+
+    bool showObjects = false;
+    SortColumn sortColumn = SortByTime;
+    bool sortAscending = false;
+    std::vector<pd::Instance::DSPProfileEntry> objectStatistics;
+
+    std::unique_ptr<FileChooser> saveChooser;
+
+    std::array<TextButton, 4> buttons = { TextButton(Icons::Power), TextButton(Icons::Sine), TextButton(Icons::ClearLarge), TextButton(Icons::Save) };
+};
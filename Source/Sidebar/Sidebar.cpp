@@ -17,6 +17,7 @@
 #include "DocumentBrowser.h"
 #include "AutomationPanel.h"
 #include "SearchPanel.h"
+#include "PerformancePanel.h"
 
 Sidebar::Sidebar(PluginProcessor* instance, PluginEditor* parent)
     : pd(instance)
@@ -27,6 +28,7 @@ Sidebar::Sidebar(PluginProcessor* instance, PluginEditor* parent)
     browser = new DocumentBrowser(pd);
     automationPanel = new AutomationPanel(pd);
     searchPanel = new SearchPanel(parent);
+    performancePanel = new PerformancePanel(pd, parent);
 
     inspector->setAlwaysOnTop(true);
 
@@ -35,12 +37,14 @@ Sidebar::Sidebar(PluginProcessor* instance, PluginEditor* parent)
     addChildComponent(browser);
     addChildComponent(automationPanel);
     addChildComponent(searchPanel);
+    addChildComponent(performancePanel);
 
     browser->addMouseListener(this, true);
     console->addMouseListener(this, true);
     automationPanel->addMouseListener(this, true);
     inspector->addMouseListener(this, true);
     searchPanel->addMouseListener(this, true);
+    performancePanel->addMouseListener(this, true);
 
     consoleButton.setTooltip("Open console panel");
     consoleButton.setConnectedEdges(12);
@@ -77,10 +81,20 @@ Sidebar::Sidebar(PluginProcessor* instance, PluginEditor* parent)
     };
     addAndMakeVisible(searchButton);
 
+    performanceButton.setTooltip("Open performance panel");
+    performanceButton.setConnectedEdges(12);
+    performanceButton.getProperties().set("Style", "SmallIcon");
+    performanceButton.setClickingTogglesState(true);
+    performanceButton.onClick = [this]() {
+        showPanel(4);
+    };
+    addAndMakeVisible(performanceButton);
+
     browserButton.setRadioGroupId(1100);
     automationButton.setRadioGroupId(1100);
     consoleButton.setRadioGroupId(1100);
     searchButton.setRadioGroupId(1100);
+    performanceButton.setRadioGroupId(1100);
 
     consoleButton.setToggleState(true, dontSendNotification);
 
@@ -98,6 +112,7 @@ Sidebar::~Sidebar()
     delete browser;
     delete automationPanel;
     delete searchPanel;
+    delete performancePanel;
 }
 
 void Sidebar::paint(Graphics& g)
@@ -124,18 +139,20 @@ void Sidebar::resized()
 {
     auto bounds = getLocalBounds();
     auto tabbarBounds = bounds.removeFromTop(26);
-    int buttonWidth = getWidth() / 4;
+    int buttonWidth = getWidth() / 5;
 
     consoleButton.setBounds(tabbarBounds.removeFromLeft(buttonWidth));
     browserButton.setBounds(tabbarBounds.removeFromLeft(buttonWidth));
     automationButton.setBounds(tabbarBounds.removeFromLeft(buttonWidth));
     searchButton.setBounds(tabbarBounds.removeFromLeft(buttonWidth));
+    performanceButton.setBounds(tabbarBounds.removeFromLeft(buttonWidth));
 
     browser->setBounds(bounds);
     console->setBounds(bounds);
     inspector->setBounds(bounds);
     automationPanel->setBounds(bounds);
     searchPanel->setBounds(bounds);
+    performancePanel->setBounds(bounds);
 }
 
 void Sidebar::mouseDown(MouseEvent const& e)
@@ -185,13 +202,14 @@ void Sidebar::showPanel(int panelToShow)
     bool showBrowser = panelToShow == 1;
     bool showAutomation = panelToShow == 2;
     bool showSearch = panelToShow == 3;
+    bool showPerformance = panelToShow == 4;
 
     console->setVisible(showConsole);
 
     browser->setVisible(showBrowser);
     browser->setInterceptsMouseClicks(showBrowser, showBrowser);
 
-    auto buttons = std::vector<TextButton*> { &consoleButton, &browserButton, &automationButton, &searchButton };
+    auto buttons = std::vector<TextButton*> { &consoleButton, &browserButton, &automationButton, &searchButton, &performanceButton };
 
     for (int i = 0; i < buttons.size(); i++) {
         buttons[i]->setToggleState(i == panelToShow, dontSendNotification);
@@ -206,6 +224,9 @@ void Sidebar::showPanel(int panelToShow)
         searchPanel->grabFocus();
     searchPanel->setInterceptsMouseClicks(showSearch, showSearch);
 
+    performancePanel->setVisible(showPerformance);
+    performancePanel->setInterceptsMouseClicks(showPerformance, showPerformance);
+
     hideParameters();
 
     currentPanel = panelToShow;
@@ -275,6 +296,7 @@ void Sidebar::showParameters()
         browser->setVisible(false);
         searchPanel->setVisible(false);
         automationPanel->setVisible(false);
+        performancePanel->setVisible(false);
     }
 }
 void Sidebar::hideParameters()
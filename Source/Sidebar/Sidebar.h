@@ -14,6 +14,7 @@ struct Inspector;
 struct DocumentBrowser;
 struct AutomationPanel;
 struct SearchPanel;
+class PerformancePanel;
 struct PluginProcessor;
 
 namespace pd {
@@ -89,12 +90,14 @@ private:
     TextButton browserButton = TextButton(Icons::Documentation);
     TextButton automationButton = TextButton(Icons::Parameters);
     TextButton searchButton = TextButton(Icons::Search);
+    TextButton performanceButton = TextButton(Icons::History);
 
     Console* console;
     Inspector* inspector;
     DocumentBrowser* browser;
     AutomationPanel* automationPanel;
     SearchPanel* searchPanel;
+    PerformancePanel* performancePanel;
 
     int currentPanel = 0;
 
@@ -223,6 +223,15 @@ int PlugDataWindow::parseSystemArguments(String const& arguments)
     int retval = parse_startup_arguments(argv, argc, &openlist, &messagelist);
 
     StringArray openedPatches;
+
+    if (auto* pd = dynamic_cast<PluginProcessor*>(getAudioProcessor())) {
+        Array<File> patchFiles;
+        for (auto* nl = openlist; nl; nl = nl->nl_next) {
+            patchFiles.add(File(String(nl->nl_string).unquoted()));
+        }
+        pd->patchCache.prefetch(patchFiles);
+    }
+
     /* open patches specifies with "-open" args */
     for (auto* nl = openlist; nl; nl = nl->nl_next) {
         auto toOpen = File(String(nl->nl_string).unquoted());
@@ -205,11 +205,16 @@ Statusbar::Statusbar(PluginProcessor* processor)
         menu.addItem(2, "2x");
         menu.addItem(3, "4x");
         menu.addItem(4, "8x");
+        menu.addSeparator();
+        menu.addItem(5, "Linear phase", true, pd->oversamplingFilter == PluginProcessor::LinearPhaseFIR);
 
         auto* editor = pd->getActiveEditor();
         menu.showMenuAsync(PopupMenu::Options().withMinimumWidth(100).withMaximumNumColumns(1).withTargetComponent(&oversampleSelector).withParentComponent(editor),
             [this](int result) {
-                if (result != 0) {
+                if (result == 5) {
+                    auto const linearPhase = pd->oversamplingFilter != PluginProcessor::LinearPhaseFIR;
+                    pd->setOversamplingFilter(linearPhase ? PluginProcessor::LinearPhaseFIR : PluginProcessor::MinimumPhaseIIR);
+                } else if (result != 0) {
                     oversampleSelector.setButtonText(String(1 << (result - 1)) + "x");
                     pd->setOversampling(result - 1);
                 }
@@ -476,6 +481,21 @@ void Statusbar::audioProcessedChanged(bool audioProcessed)
     powerButton->setColour(TextButton::textColourOnId, colour);
 }
 
+void Statusbar::protectedModeActiveChanged(bool active, int64 numClipped, int64 numReplaced)
+{
+    if (active) {
+        protectButton->setColour(TextButton::textColourOnId, Colours::orange);
+    } else {
+        protectButton->removeColour(TextButton::textColourOnId);
+    }
+
+    auto tooltip = String("Clip output signal and filter non-finite values");
+    if (active) {
+        tooltip += "\nClipped samples: " + String(numClipped) + "\nNon-finite samples: " + String(numReplaced);
+    }
+    protectButton->setTooltip(tooltip);
+}
+
 StatusbarSource::StatusbarSource()
 {
     level[0] = 0.0f;
@@ -540,6 +560,16 @@ void StatusbarSource::prepareToPlay(int nChannels)
     numChannels = nChannels;
 }
 
+void StatusbarSource::reportSanitisedSamples(int numClipped, int numReplaced)
+{
+    if (numClipped == 0 && numReplaced == 0)
+        return;
+
+    numClippedSamples += numClipped;
+    numReplacedSamples += numReplaced;
+    lastSanitisedTime = Time::getCurrentTime().getMillisecondCounter();
+}
+
 void StatusbarSource::timerCallback()
 {
     auto currentTime = Time::getCurrentTime().getMillisecondCounter();
@@ -547,6 +577,7 @@ void StatusbarSource::timerCallback()
     auto hasReceivedMidi = currentTime - lastMidiReceivedTime < 700;
     auto hasSentMidi = currentTime - lastMidiSentTime < 700;
     auto hasProcessedAudio = currentTime - lastAudioProcessedTime < 700;
+    auto protectedModeActive = currentTime - lastSanitisedTime < 700;
 
     if (hasReceivedMidi != midiReceivedState) {
         midiReceivedState = hasReceivedMidi;
@@ -564,6 +595,15 @@ void StatusbarSource::timerCallback()
             listener->audioProcessedChanged(hasProcessedAudio);
     }
 
+    // Keep updating the counts while protected mode is kicking in, reset them once it settles
+    if (protectedModeActive || protectedModeActive != protectedModeActiveState) {
+        protectedModeActiveState = protectedModeActive;
+        auto clipped = protectedModeActive ? numClippedSamples.load() : numClippedSamples.exchange(0);
+        auto replaced = protectedModeActive ? numReplacedSamples.load() : numReplacedSamples.exchange(0);
+        for (auto* listener : listeners)
+            listener->protectedModeActiveChanged(protectedModeActive, clipped, replaced);
+    }
+
     float currentLevel[2] = { level[0].load(), level[1].load() };
     for (auto* listener : listeners) {
         listener->audioLevelChanged(currentLevel);
@@ -22,6 +22,7 @@ public:
         virtual void midiSentChanged(bool midiSent) {};
         virtual void audioProcessedChanged(bool audioProcessed) {};
         virtual void audioLevelChanged(float newLevel[2]) {};
+        virtual void protectedModeActiveChanged(bool active, int64 numClipped, int64 numReplaced) {};
         virtual void timerCallback() {};
     };
 
@@ -31,6 +32,9 @@ public:
 
     void prepareToPlay(int numChannels);
 
+    // Called from the audio thread with the result of the protected mode pass
+    void reportSanitisedSamples(int numClipped, int numReplaced);
+
     void timerCallback() override;
 
     void addListener(Listener* l);
@@ -42,11 +46,16 @@ private:
     std::atomic<int> lastAudioProcessedTime = 0;
     std::atomic<float> level[2] = { 0 };
 
+    std::atomic<int> lastSanitisedTime = 0;
+    std::atomic<int64> numClippedSamples = 0; // 64 bit, so a long session with constant clipping can't overflow them
+    std::atomic<int64> numReplacedSamples = 0;
+
     int numChannels;
 
     bool midiReceivedState = false;
     bool midiSentState = false;
     bool audioProcessedState = false;
+    bool protectedModeActiveState = false;
     std::vector<Listener*> listeners;
 };
 
@@ -75,6 +84,7 @@ public:
     void attachToCanvas(Canvas* cnv);
 
     void audioProcessedChanged(bool audioProcessed) override;
+    void protectedModeActiveChanged(bool active, int64 numClipped, int64 numReplaced) override;
 
     bool wasLocked = false; // Make sure it doesn't re-lock after unlocking (because cmd is still down)
 
@@ -499,37 +499,21 @@ private:
             if (query.length() == 0)
                 return suggestions;
 
-            std::sort(suggestions.begin(), suggestions.end(),
-                [&query](const String& a, const String& b) -> bool {
-                    auto check = [&query](const String& a, const String& b) -> bool {
-                        // Check if suggestion exacly matches query
-                        if (a == query) {
-                            return true;
-                        }
-
-                        // Check if suggestion is equal to query with "~" appended
-                        if (a == (query + "~") && b != query && b != (query + "~")) {
-                            return true;
-                        }
-
-                        // Check if suggestion is equal to query with "." appended
-                        if (a.startsWith(query + ".") && b != query && b != (query + "~") && !b.startsWith(query + ".")) {
-                            return true;
-                        }
-
-                        if (a.length() < b.length()) {
-                            return true;
-                        }
-
-                        return false;
-                    };
-
-                    if (check(a, b))
-                        return true;
-                    if (check(b, a))
-                        return false;
-
-                    return a.compareNatural(b);
+            // Exact matches first, then the signal version, then the objects of a library with that name
+            // Everything else stays in the order that the library ranked it in, which is why the sort is stable
+            auto getRank = [&query](String const& suggestion) {
+                if (suggestion == query)
+                    return 0;
+                if (suggestion == query + "~")
+                    return 1;
+                if (suggestion.startsWith(query + "."))
+                    return 2;
+                return 3;
+            };
+
+            std::stable_sort(suggestions.begin(), suggestions.end(),
+                [&getRank](String const& a, String const& b) -> bool {
+                    return getRank(a) < getRank(b);
                 });
             return suggestions;
         };
@@ -537,7 +521,7 @@ private:
         // If there's a space, open arguments panel
         if (currentText.contains(" ")) {
             state = ShowingArguments;
-            auto found = library.getArguments()[currentText.upToFirstOccurrenceOf(" ", false, false)];
+            auto found = library.getArguments(currentText.upToFirstOccurrenceOf(" ", false, false));
             for (int i = 0; i < std::min<int>(buttons.size(), static_cast<int>(found.size())); i++) {
                 auto& [type, description, init] = found[i];
                 buttons[i]->setText(type, description, false);
@@ -610,13 +594,7 @@ private:
             for (int i = 0; i < std::min<int>(buttons.size(), numOptions); i++) {
                 auto& name = suggestions[i];
 
-                auto descriptions = library.getObjectDescriptions();
-
-                if (descriptions.find(name) != descriptions.end()) {
-                    buttons[i]->setText(name, descriptions[name], true);
-                } else {
-                    buttons[i]->setText(name, "", true);
-                }
+                buttons[i]->setText(name, library.getObjectDescription(name), true);
                 buttons[i]->setInterceptsMouseClicks(true, false);
             }
 
@@ -0,0 +1,131 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+#include <bit>
+#include <limits>
+
+#if JUCE_USE_SSE_INTRINSICS
+#    include <immintrin.h>
+#elif JUCE_USE_ARM_NEON
+#    include <arm_neon.h>
+#endif
+
+// Used by protected mode: replaces NaN and Inf with zero and clamps everything else to [-1, 1]
+// Reports how many samples were touched, so we can show when it actually kicks in
+struct AudioSanitiser {
+
+    struct Result {
+        int numClipped = 0;  // Finite samples that were outside of [-1, 1]
+        int numReplaced = 0; // NaN or Inf samples that were set to zero
+
+        Result& operator+=(Result const& other)
+        {
+            numClipped += other.numClipped;
+            numReplaced += other.numReplaced;
+            return *this;
+        }
+    };
+
+    static Result process(float* data, int numSamples)
+    {
+        Result result;
+        int n = 0;
+
+#if JUCE_USE_SSE_INTRINSICS
+#    if defined(__AVX2__)
+        auto const absMask8 = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        auto const infinity8 = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        auto const one8 = _mm256_set1_ps(1.0f);
+        auto const minusOne8 = _mm256_set1_ps(-1.0f);
+
+        for (; n + 8 <= numSamples; n += 8) {
+            auto const x = _mm256_loadu_ps(data + n);
+            auto const absX = _mm256_and_ps(x, absMask8);
+            auto const finiteMask = _mm256_cmp_ps(absX, infinity8, _CMP_LT_OQ);
+
+            // Ordered compares are false for NaN, so NaN ends up as "not finite" and "not in range"
+            auto const finite = _mm256_movemask_ps(finiteMask);
+            auto const inRange = _mm256_movemask_ps(_mm256_cmp_ps(absX, one8, _CMP_LE_OQ));
+
+            if (inRange == 0xff)
+                continue;
+
+            auto const clamped = _mm256_min_ps(_mm256_max_ps(x, minusOne8), one8);
+            _mm256_storeu_ps(data + n, _mm256_and_ps(clamped, finiteMask));
+
+            result.numReplaced += 8 - std::popcount(static_cast<unsigned>(finite));
+            result.numClipped += std::popcount(static_cast<unsigned>(finite & ~inRange));
+        }
+#    endif
+        auto const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        auto const infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        auto const one = _mm_set1_ps(1.0f);
+        auto const minusOne = _mm_set1_ps(-1.0f);
+
+        for (; n + 4 <= numSamples; n += 4) {
+            auto const x = _mm_loadu_ps(data + n);
+            auto const absX = _mm_and_ps(x, absMask);
+            auto const finiteMask = _mm_cmplt_ps(absX, infinity);
+
+            auto const finite = _mm_movemask_ps(finiteMask);
+            auto const inRange = _mm_movemask_ps(_mm_cmple_ps(absX, one));
+
+            if (inRange == 0xf)
+                continue;
+
+            // maxps returns its second operand for NaN, the finite mask takes care of zeroing it
+            auto const clamped = _mm_min_ps(_mm_max_ps(x, minusOne), one);
+            _mm_storeu_ps(data + n, _mm_and_ps(clamped, finiteMask));
+
+            result.numReplaced += 4 - std::popcount(static_cast<unsigned>(finite));
+            result.numClipped += std::popcount(static_cast<unsigned>(finite & ~inRange));
+        }
+#elif JUCE_USE_ARM_NEON
+        auto const infinity = vdupq_n_f32(std::numeric_limits<float>::infinity());
+        auto const one = vdupq_n_f32(1.0f);
+        auto const minusOne = vdupq_n_f32(-1.0f);
+
+        for (; n + 4 <= numSamples; n += 4) {
+            auto const x = vld1q_f32(data + n);
+            auto const absX = vabsq_f32(x);
+
+            // Compares against NaN are false, so NaN counts as "not finite" and "not in range"
+            auto const finiteMask = vcltq_f32(absX, infinity);
+            auto const inRangeMask = vcleq_f32(absX, one);
+
+            auto const finite = vshrq_n_u32(finiteMask, 31);
+            auto const clipped = vshrq_n_u32(vbicq_u32(finiteMask, inRangeMask), 31);
+            auto const numFinite = vgetq_lane_u32(finite, 0) + vgetq_lane_u32(finite, 1) + vgetq_lane_u32(finite, 2) + vgetq_lane_u32(finite, 3);
+            auto const numClipped = vgetq_lane_u32(clipped, 0) + vgetq_lane_u32(clipped, 1) + vgetq_lane_u32(clipped, 2) + vgetq_lane_u32(clipped, 3);
+
+            if (numFinite == 4 && numClipped == 0)
+                continue;
+
+            auto const clamped = vminq_f32(vmaxq_f32(x, minusOne), one);
+            vst1q_f32(data + n, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(clamped), finiteMask)));
+
+            result.numReplaced += 4 - static_cast<int>(numFinite);
+            result.numClipped += static_cast<int>(numClipped);
+        }
+#endif
+
+        // Scalar fallback, also handles the samples that don't fill up a full vector
+        for (; n < numSamples; n++) {
+            if (!std::isfinite(data[n])) {
+                data[n] = 0.0f;
+                result.numReplaced++;
+            } else if (data[n] > 1.0f || data[n] < -1.0f) {
+                data[n] = std::clamp(data[n], -1.0f, 1.0f);
+                result.numClipped++;
+            }
+        }
+
+        return result;
+    }
+};
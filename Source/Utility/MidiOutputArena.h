@@ -0,0 +1,66 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+// Preallocated storage for the MIDI that Pd sends out during a block, written straight from Pd's MIDI hooks
+// Pd produces events in time order, so they can be appended and never need sorting
+class MidiOutputArena {
+
+public:
+    explicit MidiOutputArena(size_t capacityInBytes = 1 << 16)
+        : storage(capacityInBytes)
+    {
+    }
+
+    // Returns false if the arena is full, in which case the event gets dropped
+    bool add(int samplePosition, uint8 const* data, int numBytes)
+    {
+        if (numBytes <= 0 || numBytes > std::numeric_limits<uint16>::max() || writePosition + headerSize + numBytes > storage.size())
+            return false;
+
+        auto const size = static_cast<uint16>(numBytes);
+        auto* destination = storage.data() + writePosition;
+        std::memcpy(destination, &samplePosition, sizeof(int));
+        std::memcpy(destination + sizeof(int), &size, sizeof(uint16));
+        std::memcpy(destination + headerSize, data, numBytes);
+
+        writePosition += headerSize + numBytes;
+        return true;
+    }
+
+    // Calls callback(samplePosition, data, numBytes) for every event, in the order they were added
+    template<typename Callback>
+    void forEach(Callback&& callback) const
+    {
+        for (size_t position = 0; position < writePosition;) {
+            int samplePosition;
+            uint16 size;
+            std::memcpy(&samplePosition, storage.data() + position, sizeof(int));
+            std::memcpy(&size, storage.data() + position + sizeof(int), sizeof(uint16));
+
+            callback(samplePosition, storage.data() + position + headerSize, static_cast<int>(size));
+            position += headerSize + size;
+        }
+    }
+
+    void clear()
+    {
+        writePosition = 0;
+    }
+
+    bool isEmpty() const
+    {
+        return writePosition == 0;
+    }
+
+private:
+    static constexpr size_t headerSize = sizeof(int) + sizeof(uint16);
+
+    std::vector<uint8> storage;
+    size_t writePosition = 0;
+};
@@ -21,6 +21,7 @@ public:
         , name(defaultName)
     {
         value = range.convertFrom0to1(getDefaultValue());
+        receiveSymbol = processor.generateSymbol(defaultName);
     }
 
     ~PlugDataParameter() {};
@@ -38,6 +39,12 @@ public:
     void setName(String const& newName)
     {
         name = newName;
+
+        // Resolve the receiver once, so the audio thread never has to look it up by name
+        // gensym isn't thread-safe, so that happens in pd's command queue, which runs with the audio thread locked
+        processor.enqueueFunctionAsync([this, newName]() {
+            receiveSymbol = processor.generateSymbol(newName);
+        });
     }
 
     String getName(int maximumStringLength) const override
@@ -57,6 +64,9 @@ public:
     void setEnabled(bool shouldBeEnabled)
     {
         enabled = shouldBeEnabled;
+
+        if (shouldBeEnabled)
+            processor.markParameterDirty(getParameterIndex());
     }
 
     NormalisableRange<float> const& getNormalisableRange() const override
@@ -80,6 +90,7 @@ public:
     void setUnscaledValueNotifyingHost(float newValue)
     {
         value = std::clamp(newValue, range.start, range.end);
+        processor.markParameterDirty(getParameterIndex());
         sendValueChangedMessageToListeners(getValue());
     }
 
@@ -91,6 +102,7 @@ public:
     void setValue(float newValue) override
     {
         value = range.convertFrom0to1(newValue);
+        processor.markParameterDirty(getParameterIndex());
     }
 
     float getDefaultValue() const override
@@ -213,6 +225,11 @@ public:
         }
     }
 
+    t_symbol* getReceiveSymbol() const
+    {
+        return receiveSymbol.load();
+    }
+
     void setLastValue(float v)
     {
         lastValue = v;
@@ -245,6 +262,7 @@ private:
     float const defaultValue;
 
     std::atomic<float> value;
+    std::atomic<t_symbol*> receiveSymbol = nullptr;
     NormalisableRange<float> range;
     String name;
     bool enabled = false;
@@ -88,6 +88,7 @@ private:
         { "browser_path", var(homeDir.getChildFile("Library").getFullPathName()) },
         { "theme", var("light") },
         { "oversampling", var(0) },
+        { "oversampling_filter", var(0) },
         { "protected", var(1) },
         { "internal_synth", var(0) },
         { "grid_enabled", var(1) },
@@ -97,7 +98,8 @@ private:
         { "default_font", var("Inter") },
         { "native_window", var(false) },
         { "reload_last_state", var(false) },
-        { "autoconnect", var(true) }
+        { "autoconnect", var(true) },
+        { "batched_rendering", var(false) }
     };
 
     StringArray childTrees {
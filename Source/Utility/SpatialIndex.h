@@ -0,0 +1,156 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over component bounds, so we can find what's near a point or inside an area without looking at everything on the canvas
+// Items that are very large go into a separate list that every query checks, so they don't end up in thousands of cells
+template<typename T>
+class SpatialIndex {
+
+public:
+    static constexpr int cellSize = 128;
+    static constexpr int maxCellsPerItem = 256;
+
+    void update(T* item, Rectangle<int> bounds)
+    {
+        auto it = items.find(item);
+        if (it != items.end()) {
+            if (it->second == bounds)
+                return;
+
+            removeFromCells(item, it->second);
+            it->second = bounds;
+        } else {
+            items.emplace(item, bounds);
+        }
+
+        addToCells(item, bounds);
+    }
+
+    void remove(T* item)
+    {
+        auto it = items.find(item);
+        if (it == items.end())
+            return;
+
+        removeFromCells(item, it->second);
+        items.erase(it);
+    }
+
+    void clear()
+    {
+        cells.clear();
+        oversized.clear();
+        items.clear();
+    }
+
+    // Returns all items whose bounds intersect the area, in no particular order
+    Array<T*> query(Rectangle<int> area) const
+    {
+        std::vector<T*> candidates;
+
+        auto const addCell = [&candidates](std::vector<T*> const& cell) {
+            candidates.insert(candidates.end(), cell.begin(), cell.end());
+        };
+
+        // When the area is large compared to how much is in the index, walking the occupied cells is cheaper
+        if (getNumCells(area) > static_cast<int64>(cells.size())) {
+            for (auto const& [key, cell] : cells) {
+                auto const cellBounds = Rectangle<int>(static_cast<int>(key >> 32) * cellSize, static_cast<int>(static_cast<int32>(key & 0xffffffff)) * cellSize, cellSize, cellSize);
+                if (cellBounds.intersects(area))
+                    addCell(cell);
+            }
+        } else {
+            forEachCell(area, [this, &addCell](int64 key) {
+                if (auto it = cells.find(key); it != cells.end())
+                    addCell(it->second);
+            });
+        }
+
+        candidates.insert(candidates.end(), oversized.begin(), oversized.end());
+
+        // An item can be in more than one cell
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        Array<T*> result;
+        for (auto* item : candidates) {
+            if (items.at(item).intersects(area))
+                result.add(item);
+        }
+
+        return result;
+    }
+
+private:
+    static int toCell(int coordinate)
+    {
+        return coordinate >= 0 ? coordinate / cellSize : (coordinate - cellSize + 1) / cellSize;
+    }
+
+    static int64 getCellKey(int x, int y)
+    {
+        return (static_cast<int64>(x) << 32) | static_cast<uint32>(y);
+    }
+
+    static int64 getNumCells(Rectangle<int> bounds)
+    {
+        auto const width = static_cast<int64>(toCell(bounds.getRight()) - toCell(bounds.getX()) + 1);
+        auto const height = static_cast<int64>(toCell(bounds.getBottom()) - toCell(bounds.getY()) + 1);
+        return width * height;
+    }
+
+    template<typename Callback>
+    static void forEachCell(Rectangle<int> bounds, Callback&& callback)
+    {
+        for (int x = toCell(bounds.getX()); x <= toCell(bounds.getRight()); x++) {
+            for (int y = toCell(bounds.getY()); y <= toCell(bounds.getBottom()); y++) {
+                callback(getCellKey(x, y));
+            }
+        }
+    }
+
+    void addToCells(T* item, Rectangle<int> bounds)
+    {
+        if (getNumCells(bounds) > maxCellsPerItem) {
+            oversized.push_back(item);
+            return;
+        }
+
+        forEachCell(bounds, [this, item](int64 key) {
+            cells[key].push_back(item);
+        });
+    }
+
+    void removeFromCells(T* item, Rectangle<int> bounds)
+    {
+        if (getNumCells(bounds) > maxCellsPerItem) {
+            oversized.erase(std::remove(oversized.begin(), oversized.end(), item), oversized.end());
+            return;
+        }
+
+        forEachCell(bounds, [this, item](int64 key) {
+            auto it = cells.find(key);
+            if (it == cells.end())
+                return;
+
+            auto& cell = it->second;
+            cell.erase(std::remove(cell.begin(), cell.end(), item), cell.end());
+
+            if (cell.empty())
+                cells.erase(it);
+        });
+    }
+
+    std::unordered_map<int64, std::vector<T*>> cells;
+    std::vector<T*> oversized;
+    std::unordered_map<T*, Rectangle<int>> items;
+};
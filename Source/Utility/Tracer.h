@@ -0,0 +1,233 @@
+/*
+ // Copyright (c) 2021-2022 Timothy Schoen
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+// Lightweight timing of the audio engine stages
+// Every thread that records gets its own ring buffer, so recording never locks and never allocates
+// The message thread collects new events from all rings periodically, if nobody collects the oldest events get overwritten
+// Rings of threads that stopped recording are handed out again, so short-lived threads don't use them up for good
+class Tracer {
+
+public:
+    struct Event {
+        char const* name; // Must be a string literal
+        int64 start;      // In high resolution ticks
+        int64 end;
+        int threadIndex;
+    };
+
+    static constexpr int maxThreads = 8;
+    static constexpr int64 eventsPerThread = 1 << 14;
+    static constexpr uint32 idleTimeBeforeReuse = 2000; // In milliseconds
+
+    bool isEnabled() const
+    {
+        return enabled.load(std::memory_order_acquire);
+    }
+
+    // Call from the message thread, the ring buffers are only allocated the first time tracing gets enabled
+    void setEnabled(bool shouldBeEnabled)
+    {
+        if (shouldBeEnabled && !rings) {
+            rings = std::make_unique<Ring[]>(maxThreads);
+        }
+
+        enabled = shouldBeEnabled;
+    }
+
+    void record(char const* name, int64 start, int64 end)
+    {
+        auto* ring = getRingForCurrentThread();
+        if (!ring) {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // collect() can hand the ring to another thread, check that it's still ours now that we've marked it as busy
+        ring->isWriting.store(true);
+        if (ring->threadId.load() != Thread::getCurrentThreadId()) {
+            ring->isWriting.store(false, std::memory_order_release);
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Single writer per ring, so a relaxed load of our own write position is fine
+        auto const position = ring->writePosition.load(std::memory_order_relaxed);
+        ring->events[position & (eventsPerThread - 1)] = { name, start, end, static_cast<int>(ring - rings.get()) };
+        ring->writePosition.store(position + 1, std::memory_order_release);
+
+        ring->isWriting.store(false, std::memory_order_release);
+    }
+
+    // Number of events that couldn't be recorded because all rings were taken
+    uint64 getNumDroppedEvents() const
+    {
+        return droppedEvents.load(std::memory_order_relaxed);
+    }
+
+    // Appends all events that were recorded since the last call, should only be called from the message thread
+    void collect(std::vector<Event>& result)
+    {
+        if (!rings)
+            return;
+
+        auto const now = Time::getMillisecondCounter();
+
+        for (int i = 0; i < maxThreads; i++) {
+            auto& ring = rings[i];
+            if (ring.threadId.load(std::memory_order_acquire) == nullptr)
+                continue;
+
+            auto const writePosition = static_cast<int64>(ring.writePosition.load(std::memory_order_acquire));
+            auto const readPosition = std::max(ring.readPosition, writePosition - eventsPerThread);
+
+            auto const firstNewEvent = result.size();
+            for (auto n = readPosition; n < writePosition; n++) {
+                result.push_back(ring.events[n & (eventsPerThread - 1)]);
+            }
+
+            // The writer may have lapped us while we were copying, drop everything it could have overwritten
+            auto const overwrittenUntil = static_cast<int64>(ring.writePosition.load(std::memory_order_acquire)) - eventsPerThread;
+            auto const numTorn = std::clamp<int64>(overwrittenUntil - readPosition, 0, writePosition - readPosition);
+            result.erase(result.begin() + static_cast<long>(firstNewEvent), result.begin() + static_cast<long>(firstNewEvent + numTorn));
+
+            if (writePosition != ring.readPosition || ring.lastActive == 0)
+                ring.lastActive = now;
+
+            ring.readPosition = writePosition;
+
+            // The thread hasn't recorded anything for a while, it probably exited, so let another thread have the ring
+            if (now - ring.lastActive > idleTimeBeforeReuse)
+                releaseRing(ring);
+        }
+    }
+
+    String getThreadName(int threadIndex) const
+    {
+        if (!rings || !isPositiveAndBelow(threadIndex, maxThreads) || rings[threadIndex].threadId.load() == nullptr)
+            return {};
+
+        return rings[threadIndex].isMessageThread.load() ? "Message thread" : "Thread " + String(threadIndex);
+    }
+
+    // Chrome trace event format, can be loaded into chrome://tracing or Perfetto
+    static String toChromeTrace(std::vector<Event> const& events, Tracer const& tracer)
+    {
+        auto traceEvents = Array<var>();
+        auto const origin = events.empty() ? 0 : std::min_element(events.begin(), events.end(), [](auto const& a, auto const& b) { return a.start < b.start; })->start;
+
+        for (int i = 0; i < maxThreads; i++) {
+            auto name = tracer.getThreadName(i);
+            if (name.isEmpty())
+                continue;
+
+            auto* metadata = new DynamicObject();
+            metadata->setProperty("name", "thread_name");
+            metadata->setProperty("ph", "M");
+            metadata->setProperty("pid", 1);
+            metadata->setProperty("tid", i);
+
+            auto* args = new DynamicObject();
+            args->setProperty("name", name);
+            metadata->setProperty("args", var(args));
+
+            traceEvents.add(var(metadata));
+        }
+
+        for (auto const& event : events) {
+            auto* object = new DynamicObject();
+            object->setProperty("name", String(event.name));
+            object->setProperty("ph", "X");
+            object->setProperty("pid", 1);
+            object->setProperty("tid", event.threadIndex);
+            object->setProperty("ts", Time::highResolutionTicksToSeconds(event.start - origin) * 1e6);
+            object->setProperty("dur", Time::highResolutionTicksToSeconds(event.end - event.start) * 1e6);
+            traceEvents.add(var(object));
+        }
+
+        auto* root = new DynamicObject();
+        root->setProperty("traceEvents", traceEvents);
+        root->setProperty("displayTimeUnit", "ms");
+
+        return JSON::toString(var(root), true);
+    }
+
+private:
+    struct Ring {
+        std::atomic<Thread::ThreadID> threadId = nullptr;
+        std::atomic<bool> isMessageThread = false;
+        std::atomic<uint64> writePosition = 0;
+        std::atomic<bool> isWriting = false;
+        int64 readPosition = 0; // Only touched by the collecting thread
+        uint32 lastActive = 0;  // Only touched by the collecting thread
+        Event events[eventsPerThread];
+    };
+
+    void releaseRing(Ring& ring)
+    {
+        ring.threadId.store(nullptr);
+
+        // If the old owner was in the middle of a write, let it finish, it will see the ring is gone before its next write
+        while (ring.isWriting.load())
+            Thread::yield();
+
+        ring.lastActive = 0;
+    }
+
+    Ring* getRingForCurrentThread()
+    {
+        if (!rings)
+            return nullptr;
+
+        auto const currentThread = Thread::getCurrentThreadId();
+
+        for (int i = 0; i < maxThreads; i++) {
+            if (rings[i].threadId.load(std::memory_order_relaxed) == currentThread)
+                return &rings[i];
+        }
+
+        // First event from this thread: claim a free ring
+        for (int i = 0; i < maxThreads; i++) {
+            Thread::ThreadID expected = nullptr;
+            if (rings[i].threadId.compare_exchange_strong(expected, currentThread, std::memory_order_acq_rel)) {
+                rings[i].isMessageThread = MessageManager::existsAndIsCurrentThread();
+                return &rings[i];
+            }
+        }
+
+        // All rings are taken, drop the event
+        return nullptr;
+    }
+
+    std::atomic<bool> enabled = false;
+    std::atomic<uint64> droppedEvents = 0;
+    std::unique_ptr<Ring[]> rings;
+};
+
+// Records the time between construction and destruction, does nothing while the tracer is disabled
+struct ScopedTrace {
+    ScopedTrace(Tracer& tracerToUse, char const* stageName)
+        : tracer(tracerToUse)
+        , name(stageName)
+        , start(tracer.isEnabled() ? Time::getHighResolutionTicks() : 0)
+    {
+    }
+
+    ~ScopedTrace()
+    {
+        if (start != 0 && tracer.isEnabled()) {
+            tracer.record(name, start, Time::getHighResolutionTicks());
+        }
+    }
+
+    Tracer& tracer;
+    char const* name;
+    int64 const start;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedTrace)
+};